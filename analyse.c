@@ -0,0 +1,753 @@
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "tictactoe.h"
+
+#define ANALYSE_BATCH 64 //nombre de morceaux pris d'un coup par un thread d'analyse
+#define INDEX_PATH "./history/analyse.idx"
+#define INDEX_MAGIC "TTTAIDX" //index persistant des statistiques deja calculees
+#define INDEX_VERSION 4
+
+//en-tete de l'index persistant : compteurs cumules, suivi des fichiers deja comptes
+typedef struct
+{
+	char			magic[8];
+	uint32_t		version;
+	uint32_t		nb_segments;
+	int32_t			win_by_first_player;
+	int32_t			win_by_second_player;
+	int32_t			nb_games;
+	int32_t			bad_records;
+	int32_t			win_by_first_move[MAX_SIZE + 1][MAX_CELLS]; //par taille, jamais replies
+	int32_t			win_by_second_move[MAX_SIZE + 1][MAX_CELLS];
+}					t_index_header;
+
+//segment du journal deja (en partie) compte dans l'index
+//une partie texte y est rangee comme un segment ferme d'une partie : elle n'est comptee qu'une fois
+typedef struct
+{
+	char			name[64];
+	uint32_t		records; //nombre de parties du segment deja comptees
+	uint32_t		closed; //1 si le segment avait son pied de page : il ne changera plus
+}					t_index_segment;
+
+//morceau de travail : un fichier texte, ou un bloc de parties d'un segment deja projete en memoire
+typedef struct
+{
+	long				name; //indice du nom du fichier texte (-1 pour un bloc de journal)
+	const unsigned char	*begin;
+	const unsigned char	*end;
+	long				skip; //parties du debut du bloc deja comptees dans l'index
+}					t_analyse_item;
+
+//fichiers projetes en memoire par le thread principal (segments du journal binaire)
+typedef struct
+{
+	void			*addr;
+	size_t			len;
+}					t_mapping;
+
+//etat partage par les threads d'analyse
+typedef struct
+{
+	t_analyse_item	*items;
+	long			nb_items;
+	long			cap_items;
+	char			*names; //noms des fichiers texte mis bout a bout
+	size_t			names_len;
+	size_t			names_cap;
+	size_t			*name_offsets;
+	long			nb_names;
+	long			cap_names;
+	t_mapping		*maps;
+	long			nb_maps;
+	long			cap_maps;
+	const char		*dir; //dossier des fichiers texte
+	atomic_long		next_item;
+	int				use_index; //1 : on ne lit que ce qui n'est pas deja dans l'index
+	t_index_header	index;
+	t_index_segment	*segments; //segments connus, tries par nom
+	long			nb_segments;
+	long			cap_segments;
+	char			*seen; //segments encore presents dans le dossier
+	long			nb_known; //segments lus dans l'index (les suivants sont nouveaux)
+}					t_analyse_work;
+
+//thread d'analyse : ses compteurs partiels et l'etat partage
+typedef struct
+{
+	t_analyse		partial;
+	t_analyse_work	*work;
+	pthread_t		thread;
+}					t_analyse_thread;
+
+//agrandit un tableau gere avec malloc (capacite doublee)
+static void	*grow(void *ptr, long *cap, size_t elem)
+{
+	*cap = *cap ? *cap * 2 : 256;
+	ptr = realloc(ptr, (size_t)*cap * elem);
+	if (ptr == NULL)
+	{
+		fprintf(stderr, "Out of memory\n");
+		exit(EXIT_FAILURE);
+	}
+	return (ptr);
+}
+
+static void	add_item(t_analyse_work *w, long name, const unsigned char *begin,
+	const unsigned char *end)
+{
+	if (w->nb_items == w->cap_items)
+		w->items = grow(w->items, &w->cap_items, sizeof(t_analyse_item));
+	w->items[w->nb_items].name = name;
+	w->items[w->nb_items].begin = begin;
+	w->items[w->nb_items].end = end;
+	w->items[w->nb_items].skip = 0;
+	w->nb_items++;
+}
+
+//garde le nom d'un fichier texte et ajoute le morceau correspondant
+static void	add_text_file(t_analyse_work *w, const char *name)
+{
+	size_t	len;
+	long	cap;
+
+	len = strlen(name) + 1;
+	while (w->names_len + len > w->names_cap)
+	{
+		cap = (long)w->names_cap;
+		w->names = grow(w->names, &cap, 1);
+		w->names_cap = (size_t)cap;
+	}
+	if (w->nb_names == w->cap_names)
+		w->name_offsets = grow(w->name_offsets, &w->cap_names, sizeof(size_t));
+	memcpy(w->names + w->names_len, name, len);
+	w->name_offsets[w->nb_names] = w->names_len;
+	w->names_len += len;
+	add_item(w, w->nb_names++, NULL, NULL);
+}
+
+//projette un fichier en lecture seule, renvoie NULL si il est vide ou illisible
+static void	*map_file(const char *path, size_t *len)
+{
+	int			fd;
+	struct stat	st;
+	void		*addr;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return (NULL);
+	addr = NULL;
+	if (fstat(fd, &st) == 0 && st.st_size > 0)
+	{
+		*len = (size_t)st.st_size;
+		addr = mmap(NULL, *len, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (addr == MAP_FAILED)
+			addr = NULL;
+		else
+			madvise(addr, *len, MADV_SEQUENTIAL);
+	}
+	close(fd);
+	return (addr);
+}
+
+//projette un segment du journal et le coupe en blocs de LOG_INDEX_STRIDE parties grace a l'index
+//les skip premieres parties, deja comptees, sont sautees ; un segment non ferme forme un seul bloc
+//qui s'arrete a la derniere partie complete ; renvoie le nombre de parties du segment, -1 si ce
+//n'est pas un journal (closed dit si le segment a son pied de page)
+static long	add_log_file(t_analyse_work *w, const char *path, long skip,
+	int *closed)
+{
+	unsigned char		*buf;
+	size_t				len;
+	const unsigned char	*begin;
+	const unsigned char	*end;
+	long				nb;
+	uint64_t			off[2];
+	t_log_record		rec;
+	size_t				n;
+
+	buf = map_file(path, &len);
+	if (buf == NULL)
+		return (-1);
+	nb = gamelog_records(buf, len, &begin, &end);
+	if (nb < -1)
+	{
+		munmap(buf, len);
+		return (-1);
+	}
+	*closed = nb >= 0;
+	if (nb < 0)
+	{
+		nb = 0; //segment en cours d'ecriture : on compte les parties completes
+		while (begin < end
+			&& (n = gamelog_parse(begin, (size_t)(end - begin), &rec)) > 0)
+		{
+			if (nb++ == skip)
+				add_item(w, -1, begin, end);
+			begin += n;
+		}
+		if (nb > skip)
+			w->items[w->nb_items - 1].end = begin;
+	}
+	else if (nb > skip)
+	{
+		for (long b = skip / LOG_INDEX_STRIDE; b * LOG_INDEX_STRIDE < nb; b++)
+		{
+			memcpy(off, end + sizeof(uint64_t) * (size_t)b, sizeof(uint64_t));
+			off[1] = (uint64_t)(end - buf);
+			if ((b + 1) * LOG_INDEX_STRIDE < nb)
+				memcpy(off + 1, end + sizeof(uint64_t) * (size_t)(b + 1), sizeof(uint64_t));
+			if (off[0] > off[1] || off[1] > (uint64_t)(end - buf))
+				continue ; //index abime : le bloc est ignore
+			add_item(w, -1, buf + off[0], buf + off[1]);
+			if (b == skip / LOG_INDEX_STRIDE)
+				w->items[w->nb_items - 1].skip = skip % LOG_INDEX_STRIDE;
+		}
+	}
+	if (nb <= skip)
+	{
+		munmap(buf, len); //rien de nouveau dans ce segment
+		return (nb);
+	}
+	if (w->nb_maps == w->cap_maps)
+		w->maps = grow(w->maps, &w->cap_maps, sizeof(t_mapping));
+	w->maps[w->nb_maps].addr = buf;
+	w->maps[w->nb_maps++].len = len;
+	return (nb);
+}
+
+//lit un entier positif, renvoie -1 si il n'y a pas de chiffre
+static int	read_int(const char **p, const char *end)
+{
+	int	n;
+
+	while (*p < end && **p == ' ')
+		(*p)++;
+	if (*p >= end || **p < '0' || **p > '9')
+		return (-1);
+	n = 0;
+	while (*p < end && **p >= '0' && **p <= '9' && n < 100000)
+		n = n * 10 + *(*p)++ - '0';
+	return (n);
+}
+
+//reconnait une ligne d'un fichier d'historique texte (size:, Player N: (l, c), Player N wins, Tie)
+//renvoie le debut de la ligne suivante
+const char	*parse_history_line(const char *p, const char *end,
+	t_history_line *line)
+{
+	const char	*eol;
+
+	eol = memchr(p, '\n', (size_t)(end - p));
+	if (eol == NULL)
+		eol = end;
+	line->type = HLINE_OTHER;
+	if (eol - p >= 5 && memcmp(p, "size:", 5) == 0)
+	{
+		p += 5;
+		line->x = read_int(&p, eol);
+		if (line->x > 0)
+			line->type = HLINE_SIZE;
+	}
+	else if (eol - p >= 9 && memcmp(p, "Player ", 7) == 0)
+	{
+		line->player = p[7];
+		p += 8;
+		if (eol - p >= 3 && memcmp(p, ": (", 3) == 0)
+		{
+			p += 3;
+			line->x = read_int(&p, eol);
+			if (p < eol && *p == ',')
+				p++;
+			line->y = read_int(&p, eol);
+			if (line->x > 0 && line->y > 0 && p < eol && *p == ')')
+				line->type = HLINE_MOVE;
+		}
+		else if (eol - p >= 5 && memcmp(p, " wins", 5) == 0)
+			line->type = HLINE_WIN;
+	}
+	else if (eol - p >= 3 && memcmp(p, "Tie", 3) == 0)
+		line->type = HLINE_TIE;
+	return (eol < end ? eol + 1 : end);
+}
+
+//compte une victoire : k vaut 0 si le gagnant est le camp qui a joue le premier coup, 1 sinon,
+//et move est le premier coup du gagnant
+static void	count_win(t_analyse *a, int size, int k, int move)
+{
+	if (k == 0)
+	{
+		a->win_by_first_move[size][move]++;
+		a->win_by_first_player++;
+	}
+	else
+	{
+		a->win_by_second_move[size][move]++;
+		a->win_by_second_player++;
+	}
+}
+
+//analyse d'une partie au format texte : taille, les deux premiers coups, puis le gagnant
+//renvoie 0 si le fichier est mal forme
+static int	analyse_text(t_analyse *a, const char *p, const char *end)
+{
+	t_history_line	line;
+	int				moves[2];
+	int				size;
+	char			first; //joueur du premier coup, qui n'est pas toujours le joueur 1
+
+	p = parse_history_line(p, end, &line);
+	if (line.type != HLINE_SIZE || line.x < 3 || line.x > MAX_SIZE)
+		return (0);
+	size = line.x;
+	first = '1';
+	for (int j = 0; j < 2; j++)
+	{
+		if (p >= end)
+			return (0);
+		p = parse_history_line(p, end, &line);
+		if (line.type != HLINE_MOVE || line.x < 1 || line.x > size
+			|| line.y < 1 || line.y > size)
+			return (0);
+		moves[j] = (line.x - 1) * size + line.y - 1;
+		if (j == 0)
+			first = line.player;
+	}
+	a->nb_games++;
+	while (p < end)
+	{
+		p = parse_history_line(p, end, &line);
+		if (line.type != HLINE_WIN)
+			continue ;
+		if (line.player == '1' || line.player == '2')
+			count_win(a, size, line.player != first, moves[line.player != first]);
+		break ;
+	}
+	return (1);
+}
+
+//ajoute une partie du journal binaire aux statistiques
+static void	analyse_record(t_analyse *analyse, const t_log_record *rec)
+{
+	int	k;
+
+	analyse->nb_games++;
+	if (rec->result == LOG_RESULT_TIE || rec->nb_moves < 2)
+		return ;
+	k = rec->result == rec->first_player ? 0 : 1; //coup du gagnant : le premier ou le second
+	count_win(analyse, rec->size, k, rec->moves[k]);
+}
+
+//analyse d'un morceau : une partie mal formee est comptee et le reste du bloc est saute
+static void	analyse_item(t_analyse_thread *t, t_analyse_item *item)
+{
+	char				path[512];
+	void				*addr;
+	size_t				len;
+	const unsigned char	*p;
+	t_log_record		rec;
+	size_t				n;
+
+	if (item->name >= 0)
+	{
+		snprintf(path, sizeof(path), "%s/%s", t->work->dir,
+			t->work->names + t->work->name_offsets[item->name]);
+		addr = map_file(path, &len);
+		if (addr == NULL || !analyse_text(&t->partial, (const char *)addr,
+				(const char *)addr + len))
+			t->partial.bad_records++;
+		if (addr)
+			munmap(addr, len);
+		return ;
+	}
+	p = item->begin;
+	for (long i = 0; p < item->end; i++)
+	{
+		n = gamelog_parse(p, (size_t)(item->end - p), &rec);
+		if (n == 0)
+		{
+			t->partial.bad_records++;
+			return ;
+		}
+		if (i >= item->skip)
+			analyse_record(&t->partial, &rec);
+		p += n;
+	}
+}
+
+static void	*analyse_thread(void *arg)
+{
+	t_analyse_thread	*t;
+	long				i;
+	long				last;
+
+	t = (t_analyse_thread *)arg;
+	while (1)
+	{
+		i = atomic_fetch_add(&t->work->next_item, ANALYSE_BATCH);
+		if (i >= t->work->nb_items)
+			break ;
+		last = i + ANALYSE_BATCH;
+		if (last > t->work->nb_items)
+			last = t->work->nb_items;
+		while (i < last)
+			analyse_item(t, &t->work->items[i++]);
+	}
+	return (NULL);
+}
+
+//compteurs a zero, tableaux des coups (une ligne par taille de plateau) alloues dans l'arene
+void	init_analyse(t_arena *arena, t_analyse *analyse)
+{
+	memset(analyse, 0, sizeof(t_analyse));
+	analyse->win_by_first_move = (int **)arena_alloc(arena, sizeof(int *)
+			* (MAX_SIZE + 1));
+	analyse->win_by_second_move = (int **)arena_alloc(arena, sizeof(int *)
+			* (MAX_SIZE + 1));
+	for (int i = 0; i <= MAX_SIZE; ++i)
+	{
+		analyse->win_by_first_move[i] = (int *)arena_alloc(arena, sizeof(int)
+			* MAX_CELLS);
+		analyse->win_by_second_move[i] = (int *)arena_alloc(arena, sizeof(int)
+			* MAX_CELLS);
+	}
+}
+
+//ajoute les compteurs de src a ceux de dst
+void	merge_analyse(t_analyse *dst, const t_analyse *src)
+{
+	dst->win_by_first_player += src->win_by_first_player;
+	dst->win_by_second_player += src->win_by_second_player;
+	dst->nb_games += src->nb_games;
+	dst->bad_records += src->bad_records;
+	for (int i = 0; i <= MAX_SIZE; i++)
+	{
+		for (int j = 0; j < MAX_CELLS; j++)
+		{
+			dst->win_by_first_move[i][j] += src->win_by_first_move[i][j];
+			dst->win_by_second_move[i][j] += src->win_by_second_move[i][j];
+		}
+	}
+}
+
+static int	cmp_segment(const void *a, const void *b)
+{
+	return (strcmp(((const t_index_segment *)a)->name,
+			((const t_index_segment *)b)->name));
+}
+
+//ajoute (ou retrouve) la place d'un segment dans l'index
+static t_index_segment	*find_segment(t_analyse_work *w, const char *name)
+{
+	t_index_segment	key;
+	t_index_segment	*seg;
+
+	snprintf(key.name, sizeof(key.name), "%s", name);
+	seg = bsearch(&key, w->segments, (size_t)w->nb_known,
+			sizeof(t_index_segment), cmp_segment);
+	if (seg != NULL)
+	{
+		w->seen[seg - w->segments] = 1;
+		return (seg);
+	}
+	if (w->nb_segments == w->cap_segments)
+	{
+		w->segments = grow(w->segments, &w->cap_segments, sizeof(t_index_segment));
+		w->seen = realloc(w->seen, (size_t)w->cap_segments);
+	}
+	seg = &w->segments[w->nb_segments];
+	memset(seg, 0, sizeof(*seg));
+	memcpy(seg->name, key.name, sizeof(seg->name));
+	w->seen[w->nb_segments++] = 1;
+	return (seg);
+}
+
+//place d'un fichier dans l'index, NULL si son nom est trop long pour y etre suivi
+static t_index_segment	*index_entry(t_analyse_work *w, const char *name,
+	const char *path)
+{
+	if (strlen(name) >= sizeof(((t_index_segment *)0)->name))
+	{
+		//l'index ne pourrait pas suivre ce fichier : il serait recompte a chaque analyse
+		fprintf(stderr, "%s: name too long for the index, skipped\n", path);
+		return (NULL);
+	}
+	return (find_segment(w, name));
+}
+
+//classe une entree : segment du journal binaire, partie texte, ou autre fichier ignore
+static void	add_entry(t_analyse_work *w, const char *name)
+{
+	char			path[512];
+	t_index_segment	*seg;
+	long			nb;
+	int				closed;
+
+	snprintf(path, sizeof(path), "%s/%s", w->dir, name);
+	if (strstr(name, LOG_EXTENSION) != NULL)
+	{
+		seg = NULL;
+		if (w->use_index)
+		{
+			seg = index_entry(w, name, path);
+			if (seg == NULL || seg->closed)
+				return ; //segment ferme deja compte en entier : on ne l'ouvre meme pas
+		}
+		nb = add_log_file(w, path, seg ? (long)seg->records : 0, &closed);
+		if (nb < 0)
+			fprintf(stderr, "%s is not a game log\n", path);
+		else if (seg != NULL)
+		{
+			if (nb > (long)seg->records)
+				seg->records = (uint32_t)nb;
+			seg->closed = (uint32_t)closed;
+		}
+	}
+	else if (strstr(name, "game_coordinates_") != NULL)
+	{
+		if (w->use_index)
+		{
+			seg = index_entry(w, name, path);
+			if (seg == NULL || seg->closed)
+				return ; //partie deja comptee, meme si le fichier a ete modifie depuis
+			seg->records = 1;
+			seg->closed = 1;
+		}
+		add_text_file(w, name);
+	}
+}
+
+//charge l'index persistant ; sans index valide on repart de zero
+static void	load_index(t_analyse_work *w)
+{
+	FILE	*fp;
+
+	memset(&w->index, 0, sizeof(w->index));
+	fp = fopen(INDEX_PATH, "rb");
+	if (fp != NULL)
+	{
+		if (fread(&w->index, sizeof(w->index), 1, fp) == 1
+			&& memcmp(w->index.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0
+			&& w->index.version == INDEX_VERSION)
+		{
+			w->cap_segments = w->index.nb_segments;
+			w->segments = malloc(sizeof(t_index_segment) * (w->cap_segments + 1));
+			w->seen = calloc((size_t)w->cap_segments + 1, 1);
+			if (w->segments == NULL || w->seen == NULL
+				|| fread(w->segments, sizeof(t_index_segment),
+					w->index.nb_segments, fp) != w->index.nb_segments)
+			{
+				fprintf(stderr, "Corrupted %s, rebuilding it\n", INDEX_PATH);
+				memset(&w->index, 0, sizeof(w->index));
+				w->cap_segments = 0;
+			}
+		}
+		else
+			memset(&w->index, 0, sizeof(w->index));
+		fclose(fp);
+	}
+	w->nb_segments = w->cap_segments;
+	w->nb_known = w->nb_segments;
+	qsort(w->segments, (size_t)w->nb_segments, sizeof(t_index_segment),
+		cmp_segment);
+}
+
+//compteurs de l'index vers un t_analyse
+static void	index_to_analyse(const t_index_header *idx, t_analyse *a)
+{
+	a->win_by_first_player = idx->win_by_first_player;
+	a->win_by_second_player = idx->win_by_second_player;
+	a->nb_games = idx->nb_games;
+	a->bad_records = idx->bad_records;
+	for (int i = 0; i <= MAX_SIZE; i++)
+	{
+		for (int j = 0; j < MAX_CELLS; j++)
+		{
+			a->win_by_first_move[i][j] = idx->win_by_first_move[i][j];
+			a->win_by_second_move[i][j] = idx->win_by_second_move[i][j];
+		}
+	}
+}
+
+//ecrit l'index a jour dans un fichier temporaire puis le renomme (jamais d'index a moitie ecrit)
+static void	save_index(t_analyse_work *w, const t_analyse *a)
+{
+	FILE	*fp;
+	long	kept;
+
+	memcpy(w->index.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+	w->index.version = INDEX_VERSION;
+	w->index.win_by_first_player = a->win_by_first_player;
+	w->index.win_by_second_player = a->win_by_second_player;
+	w->index.nb_games = a->nb_games;
+	w->index.bad_records = a->bad_records;
+	for (int i = 0; i <= MAX_SIZE; i++)
+	{
+		for (int j = 0; j < MAX_CELLS; j++)
+		{
+			w->index.win_by_first_move[i][j] = a->win_by_first_move[i][j];
+			w->index.win_by_second_move[i][j] = a->win_by_second_move[i][j];
+		}
+	}
+	kept = 0;
+	for (long i = 0; i < w->nb_segments; i++)
+		if (w->seen[i]) //les segments effaces du dossier sont oublies
+			w->segments[kept++] = w->segments[i];
+	w->index.nb_segments = (uint32_t)kept;
+	fp = fopen(INDEX_PATH ".tmp", "wb");
+	if (fp == NULL)
+	{
+		fprintf(stderr, "Failed to open %s for writing\n", INDEX_PATH ".tmp");
+		return ;
+	}
+	fwrite(&w->index, sizeof(w->index), 1, fp);
+	fwrite(w->segments, sizeof(t_index_segment), (size_t)kept, fp);
+	fclose(fp);
+	adjust_file_ownership(INDEX_PATH ".tmp");
+	rename(INDEX_PATH ".tmp", INDEX_PATH);
+}
+
+//affiche les coups gagnants de chaque taille de plateau
+//avec fold, chaque case s'ajoute a son representant parmi ses images par les 8 symetries
+static void	report_moves(FILE *out, int **moves, int fold)
+{
+	int	folded[MAX_CELLS];
+
+	for (int size = 3; size <= MAX_SIZE; size++)
+	{
+		memset(folded, 0, sizeof(folded));
+		for (int cell = 0; cell < size * size; cell++)
+			folded[fold ? sym_canonical_cell(size, cell) : cell]
+				+= moves[size][cell];
+		for (int cell = 0; cell < size * size; cell++)
+			if (folded[cell] > 0)
+				fprintf(out, "%dx%d %d, %d : %d\n", size, size, cell / size + 1,
+					cell % size + 1, folded[cell]);
+	}
+}
+
+//affiche les statistiques et les ajoute a ./history/analyse.txt
+static void	report_analyse(t_analyse *analyse, int fold)
+{
+	FILE	*out[2];
+
+	out[0] = stdout;
+	out[1] = fopen("./history/analyse.txt", "a");
+	if (out[1] == NULL)
+	{
+		fprintf(stderr, "Failed to open analysis file for writing\n");
+		exit(EXIT_FAILURE);
+	}
+	adjust_file_ownership("./history/analyse.txt");
+	for (int f = 0; f < 2; f++)
+	{
+		fprintf(out[f], f == 0 ? "Number of games: %d\n"
+			: "Number of games analysed: %d\n", analyse->nb_games);
+		fprintf(out[f], "Winrate by first player: %f\n",
+			(float)analyse->win_by_first_player / ((float)analyse->nb_games));
+		fprintf(out[f], "Winrate by second player: %f\n",
+			(float)analyse->win_by_second_player / ((float)analyse->nb_games));
+		fprintf(out[f], "Tie rate: %f\n", (float)analyse->tie
+			/ ((float)analyse->nb_games));
+		fprintf(out[f], "win by first player: %d\n", analyse->win_by_first_player);
+		fprintf(out[f], "win by second player: %d\n", analyse->win_by_second_player);
+		fprintf(out[f], "tie: %d\n", analyse->tie);
+		fprintf(out[f], "bad records skipped: %d\n\n", analyse->bad_records);
+		fprintf(out[f], "Win by first move:\n");
+		report_moves(out[f], analyse->win_by_first_move, fold);
+		fprintf(out[f], "\nWin by second move:\n");
+		report_moves(out[f], analyse->win_by_second_move, fold);
+	}
+	fclose(out[1]);
+}
+
+//fonction d'analyse des parties sauvegardees
+//path : un seul fichier (journal binaire ou partie texte), ou NULL pour tout le dossier ./history
+//les fichiers sont projetes en memoire et repartis entre les threads, chacun avec ses compteurs
+//pour le dossier entier, ./history/analyse.idx garde les compteurs deja calcules : seules les
+//nouvelles parties sont lues, puis l'index est mis a jour
+//fold : les coups symetriques (par exemple les 4 coins) sont affiches sur une seule case ; l'index
+//garde toujours les compteurs non replies, le regroupement n'est fait qu'a l'affichage
+void	analyse_history(t_arena *arena, const char *path, int fold)
+{
+	DIR					*d;
+	struct dirent		*dir;
+	t_analyse_work		work;
+	t_analyse_thread	*threads;
+	t_analyse			*analyse;
+	int					nb_threads;
+	const char			*slash;
+	char				*dir_copy;
+
+	memset(&work, 0, sizeof(work));
+	work.dir = "./history";
+	dir_copy = NULL;
+	if (path != NULL)
+	{
+		slash = strrchr(path, '/');
+		work.dir = ".";
+		if (slash != NULL)
+		{
+			dir_copy = strndup(path, (size_t)(slash - path)); //le nom est relatif a son dossier
+			work.dir = dir_copy;
+		}
+		add_entry(&work, slash ? slash + 1 : path);
+	}
+	else
+	{
+		work.use_index = 1;
+		load_index(&work);
+		d = opendir(work.dir);
+		if (d == NULL)
+		{
+			fprintf(stderr, "Could not open the history directory.\n");
+			exit(EXIT_FAILURE);
+		}
+		while ((dir = readdir(d)) != NULL) //un seul passage sur le dossier
+			add_entry(&work, dir->d_name);
+		closedir(d);
+	}
+	atomic_init(&work.next_item, 0);
+	nb_threads = default_nb_workers();
+	if (nb_threads > work.nb_items / ANALYSE_BATCH + 1)
+		nb_threads = (int)(work.nb_items / ANALYSE_BATCH + 1);
+	threads = (t_analyse_thread *)arena_alloc(arena, sizeof(t_analyse_thread)
+			* nb_threads);
+	for (int i = 0; i < nb_threads; i++)
+	{
+		init_analyse(arena, &threads[i].partial);
+		threads[i].work = &work;
+		pthread_create(&threads[i].thread, NULL, analyse_thread, threads + i);
+	}
+	analyse = (t_analyse *)arena_alloc(arena, sizeof(t_analyse));
+	init_analyse(arena, analyse);
+	if (work.use_index)
+		index_to_analyse(&work.index, analyse); //on repart des compteurs deja calcules
+	for (int i = 0; i < nb_threads; i++)
+	{
+		pthread_join(threads[i].thread, NULL);
+		merge_analyse(analyse, &threads[i].partial); //reduction des compteurs partiels
+	}
+	analyse->tie = analyse->nb_games - analyse->win_by_first_player
+		- analyse->win_by_second_player;
+	if (work.use_index)
+		save_index(&work, analyse);
+	report_analyse(analyse, fold);
+	for (long i = 0; i < work.nb_maps; i++)
+		munmap(work.maps[i].addr, work.maps[i].len);
+	free(dir_copy);
+	free(work.items);
+	free(work.names);
+	free(work.name_offsets);
+	free(work.maps);
+	free(work.segments);
+	free(work.seen);
+}
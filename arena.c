@@ -0,0 +1,286 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "tictactoe.h"
+
+//fonction d'allocation custom, memset custom
+//seule la partie deja donnee une fois est remise a zero : au-dela, les pages sortent du noyau a zero
+//et ne sont pas touchees tant qu'on ne s'en sert pas ; le memset de la libc efface par mots vectoriels
+static void	*arena_memset(t_arena_chunk *chunk, void *s, size_t n)
+{
+	size_t	offset;
+	size_t	dirty;
+
+	offset = (size_t)((unsigned char *)s - (unsigned char *)(chunk + 1));
+	dirty = chunk->dirty > offset ? chunk->dirty - offset : 0;
+	memset(s, 0, dirty < n ? dirty : n);
+	if (offset + n > chunk->dirty)
+		chunk->dirty = offset + n;
+	return (s);
+}
+
+//reserve un morceau de len octets (en-tete compris) : les pages ne sont prises qu'au premier acces
+//avec -DARENA_HUGETLB on essaie d'abord les grandes pages reservees du noyau
+static t_arena_chunk	*arena_map(size_t *len)
+{
+	void	*p;
+
+	p = MAP_FAILED;
+#ifdef ARENA_HUGETLB
+	if (*len >= ARENA_HUGE_PAGE)
+	{
+		*len = (*len + ARENA_HUGE_PAGE - 1) & ~(size_t)(ARENA_HUGE_PAGE - 1);
+		p = mmap(NULL, *len, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0); //sans MAP_NORESERVE : echoue proprement sans grandes pages
+	}
+#endif
+	if (p == MAP_FAILED) //pas de grandes pages reservees : pages normales
+		p = mmap(NULL, *len, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (p == MAP_FAILED)
+		return (NULL);
+#ifdef MADV_HUGEPAGE
+	if (*len >= ARENA_HUGE_PAGE)
+		madvise(p, *len, MADV_HUGEPAGE); //grandes pages transparentes pour les gros morceaux
+#endif
+	return ((t_arena_chunk *)p);
+}
+
+//fonctions d'allocation custom, alignement de la memoire
+static int	is_power_of_two(uintptr_t x)
+{
+	return ((x & (x - 1)) == 0);
+}
+
+static uintptr_t	align_forward(uintptr_t ptr, size_t align) //si l adresse est une puissance de 2, on est aligné, sinon, on trouve le prochain entier qui en est une
+{
+	uintptr_t	p;
+	uintptr_t	a;
+	uintptr_t	modulo;
+
+	if (!is_power_of_two(align))
+		exit(1);
+	p = ptr;
+	a = (uintptr_t)align;
+	modulo = p % a;
+	if (modulo != 0)
+		p += a - modulo;
+	return (p);
+}
+
+//nouveau morceau d'au moins size octets utiles ; on reprend d'abord un morceau rendu par arena_release
+static t_arena_chunk	*arena_chunk(t_arena *a, size_t size)
+{
+	t_arena_chunk	**link;
+	t_arena_chunk	*chunk;
+
+	link = &a->spare;
+	while (*link != NULL && (*link)->size < size)
+		link = &(*link)->prev;
+	if (*link != NULL)
+	{
+		chunk = *link;
+		*link = chunk->prev;
+		return (chunk);
+	}
+	if (size < a->chunk_size)
+		size = a->chunk_size;
+	size += sizeof(t_arena_chunk);
+	chunk = arena_map(&size);
+	if (chunk == NULL)
+		return (NULL);
+	chunk->size = size - sizeof(t_arena_chunk);
+	chunk->dirty = 0;
+#ifdef ARENA_STATS
+	a->stats.mapped += size;
+	a->stats.nb_chunks++;
+#endif
+	return (chunk);
+}
+
+//le morceau courant est plein : on en enchaine un autre, assez grand pour la demande
+static int	arena_grow(t_arena *a, size_t size)
+{
+	t_arena_chunk	*chunk;
+
+	chunk = arena_chunk(a, size + ARENA_ALIGNMENT);
+	if (chunk == NULL)
+		return (0);
+	chunk->prev = a->chunk;
+	a->chunk = chunk;
+	a->buf = chunk + 1;
+	a->buf_size = chunk->size;
+	a->curr_offset = 0;
+	a->prev_offset = 0;
+	return (1);
+}
+
+#ifdef ARENA_STATS
+//compte une allocation : taille, alignement, memoire prise et fonction appelante
+static void	arena_count(t_arena *a, size_t size, size_t padding, const char *site)
+{
+	t_arena_stats	*st;
+	int				i;
+
+	st = &a->stats;
+	st->count++;
+	st->bytes += size;
+	st->padding += padding;
+	st->used += size + padding;
+	if (st->used > st->high_water)
+		st->high_water = st->used;
+	i = 0;
+	while (i < st->nb_sites && st->sites[i].name != site)
+		i++;
+	if (i == st->nb_sites && i < ARENA_SITES)
+		st->sites[st->nb_sites++].name = site;
+	if (i < st->nb_sites)
+	{
+		st->sites[i].count++;
+		st->sites[i].bytes += size;
+	}
+}
+
+//rapport de l'arene, du plus gros consommateur au plus petit
+static void	arena_report(t_arena *a)
+{
+	t_arena_stats	*st;
+	t_arena_site	tmp;
+
+	st = &a->stats;
+	for (int i = 1; i < st->nb_sites; i++)
+		for (int j = i; j > 0 && st->sites[j].bytes > st->sites[j - 1].bytes; j--)
+		{
+			tmp = st->sites[j];
+			st->sites[j] = st->sites[j - 1];
+			st->sites[j - 1] = tmp;
+		}
+	fprintf(stderr, "Arena: %zu allocations, %zu bytes, %zu bytes of padding, "
+		"high water %zu bytes, %d chunks (%zu bytes reserved)\n", st->count,
+		st->bytes, st->padding, st->high_water, st->nb_chunks, st->mapped);
+	for (int i = 0; i < st->nb_sites; i++)
+		fprintf(stderr, "  %-24s %10zu allocations %14zu bytes\n",
+			st->sites[i].name, st->sites[i].count, st->sites[i].bytes);
+}
+#endif
+
+//fonction d'allocation custom, re-allocation de la mémoire
+//site est la fonction appelante (macro arena_alloc), NULL sans statistiques
+void	*arena_alloc_site(t_arena *a, size_t size, const char *site) //equivalent de calloc
+{
+	uintptr_t	curr_ptr;
+	uintptr_t	offset;
+	void		*ptr;
+
+	curr_ptr = (uintptr_t)a->buf + (uintptr_t)a->curr_offset; //on recupere l adresse de base et on lui ajoute la taille de tout ce qu on a alloue avant qui est stocke dans curr_offset
+	offset = align_forward(curr_ptr, ARENA_ALIGNMENT); //on passe le curr_ptr que l on vient d initialiser qui est l adresse la plus proche de là ou on a de la place, donc on prend un offset plus loin qui est une puissance de 2
+	offset -= (uintptr_t)a->buf;  //On veut l'offset, soit l adresse - l adresse de base pour juste avoir la taille de la memoire
+	if (offset + size > a->buf_size) //le morceau est plein : on passe a un nouveau morceau plutot que d'echouer
+	{
+		if (!arena_grow(a, size))
+			return (NULL);
+		return (arena_alloc_site(a, size, site));
+	}
+#ifdef ARENA_STATS
+	arena_count(a, size, offset - a->curr_offset, site);
+#else
+	(void)site;
+#endif
+	ptr = &((unsigned char *)a->buf)[offset]; //on cast pour stocker l adresse qui va etre allouee dans ptr
+	a->prev_offset = offset; //on met a jour l offset dans la structure
+	a->curr_offset = offset + size;
+	arena_memset(a->chunk, ptr, size); //On initialise a 0 l espace memoire renvoyé
+	return (ptr);
+}
+
+//fonction d'allocation custom, initialisation de la pool de mémoire
+//chunk_size est la taille d'un morceau : l'arene en enchaine d'autres quand il est plein
+void	*arena_init(size_t chunk_size) //initialise la structure d arene
+{
+	t_arena	*a;
+
+	a = malloc(sizeof(t_arena));
+	if (!a)
+		return (NULL);
+	memset(&a->stats, 0, sizeof(a->stats));
+	a->chunk_size = chunk_size;
+	a->spare = NULL;
+	a->chunk = arena_chunk(a, chunk_size);
+	if (!a->chunk)
+	{
+		free(a);
+		return (NULL);
+	}
+	a->chunk->prev = NULL;
+	a->buf = a->chunk + 1;
+	a->buf_size = a->chunk->size;
+	a->curr_offset = 0;
+	a->prev_offset = 0;
+	return (a);
+}
+
+//position courante de l'arene, pour tout rendre d'un coup avec arena_release
+t_arena_mark	arena_mark(t_arena *a)
+{
+	t_arena_mark	mark;
+
+	mark.chunk = a->chunk;
+	mark.offset = a->curr_offset;
+	mark.used = a->stats.used;
+	return (mark);
+}
+
+//rend tout ce qui a ete alloue depuis la marque : les morceaux enchaines depuis sont gardes
+//de cote pour les allocations suivantes, la memoire reste constante d'un tour a l'autre
+void	arena_release(t_arena *a, t_arena_mark mark)
+{
+	t_arena_chunk	*chunk;
+
+	while (a->chunk != mark.chunk && a->chunk->prev != NULL)
+	{
+		chunk = a->chunk;
+		a->chunk = chunk->prev;
+		chunk->prev = a->spare;
+		a->spare = chunk;
+	}
+	a->buf = a->chunk + 1;
+	a->buf_size = a->chunk->size;
+	a->curr_offset = mark.offset;
+	a->prev_offset = mark.offset;
+	a->stats.used = mark.used;
+}
+
+//fonction d'allocation custom, reset de la pool de mémoire
+void	arena_reset(t_arena *a)
+{
+	t_arena_mark	first;
+
+	first.chunk = a->chunk;
+	while (first.chunk->prev != NULL)
+		first.chunk = first.chunk->prev;
+	first.offset = 0;
+	first.used = 0;
+	arena_release(a, first);
+}
+
+//fonction d'allocation custom, destruction de la pool de mémoire ( free + reset )
+void	arena_destroy(t_arena *a)
+{
+	t_arena_chunk	*chunk;
+
+#ifdef ARENA_STATS
+	arena_report(a);
+#endif
+	arena_reset(a);
+	munmap(a->chunk, sizeof(t_arena_chunk) + a->chunk->size);
+	while (a->spare != NULL)
+	{
+		chunk = a->spare;
+		a->spare = chunk->prev;
+		munmap(chunk, sizeof(t_arena_chunk) + chunk->size);
+	}
+	free(a);
+}
@@ -0,0 +1,243 @@
+#include <getopt.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "tictactoe.h"
+
+static const char	*g_levels[] = {"random", "easy", "medium", "hard", "mcts"};
+static const char	*g_placements[] = {"os", "same", "siblings", "separate"};
+
+static void	bench_usage(void)
+{
+	fprintf(stderr, "usage: tictactoe bench [--size 3-9] [--games N] [--threads N]\n"
+		"       [--ai1 LEVEL] [--ai2 LEVEL] [--seed N] [--io on|off] [--mode single|two]\n"
+		"       [--drop] [--tt-mb N] [--mcts-threads N] [--playouts N] [--time-ms N]\n"
+		"       [--policy other|fifo|rr] [--priority N] [--placement os|same|siblings|separate]\n"
+		"       [--matrix]\n"
+		"LEVEL: random, easy, medium, hard, mcts (or 0-4)\n"
+		"--matrix runs the batch for every policy, priority and placement (two threads by default)\n");
+}
+
+//niveau d'une IA, par son nom ou son numero ; -1 si il n'existe pas
+static int	parse_level(const char *s)
+{
+	for (int i = 0; i <= AI_LEVEL_MCTS; i++)
+		if (strcmp(s, g_levels[i]) == 0)
+			return (i);
+	if (s[0] >= '0' && s[0] <= '0' + AI_LEVEL_MCTS && s[1] == '\0')
+		return (s[0] - '0');
+	return (-1);
+}
+
+//politique par son nom, -2 si elle n'existe pas
+static int	parse_policy(const char *s)
+{
+	if (strcmp(s, "other") == 0)
+		return (-1);
+	if (strcmp(s, "fifo") == 0)
+		return (SCHED_FIFO);
+	if (strcmp(s, "rr") == 0)
+		return (SCHED_RR);
+	return (-2);
+}
+
+static const char	*policy_name(int policy)
+{
+	if (policy == SCHED_FIFO)
+		return ("fifo");
+	if (policy == SCHED_RR)
+		return ("rr");
+	return ("other");
+}
+
+//placement par son nom, -1 s'il n'existe pas
+static int	parse_placement(const char *s)
+{
+	for (int i = PLACE_OS; i <= PLACE_SEPARATE; i++)
+		if (strcmp(s, g_placements[i]) == 0)
+			return (i);
+	return (-1);
+}
+
+//resultat du lot en JSON sur une ligne, pour comparer les executions en integration continue
+static void	bench_print(const t_batch *b, const t_batch_result *r)
+{
+	printf("{\"size\":%d,\"games\":%d,\"workers\":%d,\"mode\":\"%s\",\"io\":%s,"
+		"\"seed\":%lu,\"ai\":[\"%s\",\"%s\"],", b->size, b->nb_games, b->nb_workers,
+		b->exec_mode == EXEC_SINGLE_THREAD ? "single" : "two", b->io ? "true" : "false",
+		(unsigned long)b->seed, g_levels[b->ais[0].level], g_levels[b->ais[1].level]);
+	printf("\"results\":{\"ai1\":%d,\"ai2\":%d,\"ties\":%d},\"moves\":%ld,"
+		"\"tablebase_moves\":%ld,\"book_moves\":%ld,", r->results[0], r->results[1],
+		r->results[2], r->moves, r->tb_moves, r->book_moves);
+	printf("\"wall_s\":%.6f,\"cpu_s\":%.6f,\"cpu_per_wall\":%.3f,"
+		"\"games_per_s\":%.1f,\"moves_per_s\":%.1f,\"dropped\":%lu",
+		r->wall, r->cpu, r->wall > 0 ? r->cpu / r->wall : 0.0,
+		r->wall > 0 ? b->nb_games / r->wall : 0.0,
+		r->wall > 0 ? r->moves / r->wall : 0.0, r->dropped);
+	if (r->has_tt)
+		printf(",\"tt\":{\"hits\":%ld,\"misses\":%ld,\"collisions\":%ld}",
+			r->tt_hits, r->tt_misses, r->tt_collisions);
+	if (b->policy != -1 || b->placement != PLACE_OS)
+		printf(",\"policy\":\"%s\",\"priority\":%d,\"placement\":\"%s\",\"sched_errors\":%d",
+			policy_name(b->policy), b->priority, g_placements[b->placement], r->sched_errors);
+	printf("}\n");
+}
+
+//une case de la matrice : le lot avec une politique, une priorite et un placement
+//une politique temps reel refusee (pas de CAP_SYS_NICE) donne une case en erreur, pas un arret
+static void	bench_cell(t_arena *arena, t_batch *b, int policy, int priority)
+{
+	t_batch_result	r;
+	int				err;
+
+	b->policy = policy;
+	b->priority = priority;
+	printf("{\"policy\":\"%s\",\"priority\":%d,\"placement\":\"%s\",",
+		policy_name(policy), priority, g_placements[b->placement]);
+	err = policy == -1 ? 0 : sched_probe(policy, priority);
+	if (err != 0)
+	{
+		printf("\"error\":\"%s\"}\n", strerror(err));
+		fflush(stdout);
+		return ;
+	}
+	run_ai_batch(arena, b, &r);
+	printf("\"games_per_s\":%.1f,\"moves_per_s\":%.1f,\"game_p50_us\":%.3f,"
+		"\"game_p99_us\":%.3f,\"wall_s\":%.6f,\"cpu_s\":%.6f,\"sched_errors\":%d}\n",
+		r.wall > 0 ? b->nb_games / r.wall : 0.0, r.wall > 0 ? r.moves / r.wall : 0.0,
+		r.latency_p50 / 1000.0, r.latency_p99 / 1000.0, r.wall, r.cpu, r.sched_errors);
+	fflush(stdout); //les cases s'affichent au fur et a mesure
+}
+
+//toutes les politiques (systeme, FIFO, RR) aux priorites extremes, dans tous les placements
+//une ligne JSON par case, avec le debit et la duree d'une partie (p50, p99)
+static void	bench_matrix(t_arena *arena, t_batch *b)
+{
+	static const int	policies[] = {SCHED_FIFO, SCHED_RR};
+
+	b->latency = 1;
+	for (int place = PLACE_OS; place <= PLACE_SEPARATE; place++)
+	{
+		b->placement = place;
+		bench_cell(arena, b, -1, 0);
+		for (int p = 0; p < 2; p++)
+		{
+			bench_cell(arena, b, policies[p], sched_get_priority_min(policies[p]));
+			bench_cell(arena, b, policies[p], sched_get_priority_max(policies[p]));
+		}
+	}
+}
+
+//./tictactoe bench [options] : un lot IA contre IA sans aucune question, resultat en JSON
+int	bench_command(t_arena *arena, int argc, char **argv)
+{
+	static const struct option	options[] = {
+		{"size", required_argument, NULL, 's'},
+		{"games", required_argument, NULL, 'g'},
+		{"threads", required_argument, NULL, 't'},
+		{"ai1", required_argument, NULL, '1'},
+		{"ai2", required_argument, NULL, '2'},
+		{"seed", required_argument, NULL, 'S'},
+		{"io", required_argument, NULL, 'i'},
+		{"mode", required_argument, NULL, 'm'},
+		{"drop", no_argument, NULL, 'd'},
+		{"tt-mb", required_argument, NULL, 'T'},
+		{"mcts-threads", required_argument, NULL, 'M'},
+		{"playouts", required_argument, NULL, 'p'},
+		{"time-ms", required_argument, NULL, 'w'},
+		{"policy", required_argument, NULL, 'P'},
+		{"priority", required_argument, NULL, 'r'},
+		{"placement", required_argument, NULL, 'c'},
+		{"matrix", no_argument, NULL, 'x'},
+		{NULL, 0, NULL, 0}};
+	t_batch						b;
+	t_batch_result				r;
+	int							opt;
+	int							matrix;
+	int							mode_set;
+
+	memset(&b, 0, sizeof(b));
+	b.size = 3;
+	b.nb_games = 10000;
+	b.policy = -1;
+	b.exec_mode = EXEC_SINGLE_THREAD;
+	b.block = 1;
+	b.seed = 1; //graine fixe par defaut : deux executions jouent les memes parties
+	matrix = 0;
+	mode_set = 0;
+	for (int i = 0; i < 2; i++)
+	{
+		b.ais[i].nb_threads = 1;
+		b.ais[i].playouts = 1000;
+	}
+	optind = 0; //argv commence a la sous-commande
+	while ((opt = getopt_long(argc, argv, "", options, NULL)) != -1)
+	{
+		if (opt == 's')
+			b.size = atoi(optarg);
+		else if (opt == 'g')
+			b.nb_games = atoi(optarg);
+		else if (opt == 't')
+			b.nb_workers = atoi(optarg);
+		else if (opt == '1' || opt == '2')
+			b.ais[opt - '1'].level = parse_level(optarg);
+		else if (opt == 'S')
+			b.seed = strtoull(optarg, NULL, 10);
+		else if (opt == 'i')
+			b.io = strcmp(optarg, "on") == 0;
+		else if (opt == 'm')
+		{
+			b.exec_mode = strcmp(optarg, "two") == 0 ? EXEC_TWO_THREADS : EXEC_SINGLE_THREAD;
+			mode_set = 1;
+		}
+		else if (opt == 'd')
+			b.block = 0;
+		else if (opt == 'T')
+			b.ais[0].tt_mb = b.ais[1].tt_mb = atol(optarg);
+		else if (opt == 'M')
+			b.ais[0].nb_threads = b.ais[1].nb_threads = atoi(optarg);
+		else if (opt == 'p')
+			b.ais[0].playouts = b.ais[1].playouts = atol(optarg);
+		else if (opt == 'w')
+			b.ais[0].time_ms = b.ais[1].time_ms = atol(optarg);
+		else if (opt == 'P')
+			b.policy = parse_policy(optarg);
+		else if (opt == 'r')
+			b.priority = atoi(optarg);
+		else if (opt == 'c')
+			b.placement = parse_placement(optarg);
+		else if (opt == 'x')
+			matrix = 1;
+		else
+		{
+			bench_usage();
+			return (EXIT_FAILURE);
+		}
+	}
+	if (optind < argc || b.size < 3 || b.size > MAX_SIZE || b.nb_games < 1
+		|| b.ais[0].level < 0 || b.ais[1].level < 0 || b.policy == -2
+		|| b.placement < 0 || b.priority < 0)
+	{
+		bench_usage();
+		return (EXIT_FAILURE);
+	}
+	if (b.nb_workers < 1)
+		b.nb_workers = default_nb_workers();
+	if (b.nb_workers > b.nb_games)
+		b.nb_workers = b.nb_games;
+	if (b.io)
+		mkdir("./history", 0755);
+	if (matrix)
+	{
+		if (!mode_set)
+			b.exec_mode = EXEC_TWO_THREADS; //le placement compte surtout quand les deux IA se passent la main
+		bench_matrix(arena, &b);
+		return (EXIT_SUCCESS);
+	}
+	run_ai_batch(arena, &b, &r);
+	bench_print(&b, &r);
+	return (EXIT_SUCCESS);
+}
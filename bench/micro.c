@@ -0,0 +1,362 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+# include <x86intrin.h>
+#endif
+
+#include "../tictactoe.h"
+
+#define MICRO_WARMUP 1000 //appels avant la mesure, et pour estimer le nombre d'appels d'une repetition
+#define MICRO_REPS 9 //repetitions mesurees, on garde la mediane et le minimum
+#define MICRO_TARGET_NS 2000000 //duree visee d'une repetition
+#define MICRO_RELEASE 4096 //allocations de arena_alloc entre deux arena_release
+#define MICRO_TEXT 4096
+#define MICRO_BLOCK 1024 //plateaux du lot de win_batch
+
+static const char	*g_states[] = {"empty", "mid", "near_full"};
+static const char	*g_impls[] = {"win_batch_scalar", "win_batch_sse2", "win_batch_avx2"};
+static volatile long	g_sink; //les resultats y finissent : le compilateur ne peut pas supprimer les appels
+
+//contexte commun des noyaux mesures
+typedef struct
+{
+	t_board			*board; //position fixe
+	t_board			*scratch; //plateau reinitialise par init_board
+	t_rng			rng;
+	t_arena			*arena;
+	size_t			bytes; //taille des allocations de arena_alloc
+	const char		*text; //partie au format texte de l'historique
+	size_t			text_len;
+	t_board_soa		soa; //lot de plateaux de win_batch
+	int				impl;
+	uint64_t		*wins;
+	uint64_t		*ties;
+}					t_micro;
+
+//un noyau fait iters appels (ou passes) et renvoie le nombre d'operations faites
+typedef long	(*t_kernel)(t_micro *m, long iters);
+
+static uint64_t	micro_ns(void)
+{
+	struct timespec	ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+}
+
+//compteur de cycles de reference (TSC), 0 sur les autres architectures
+static uint64_t	micro_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return (__rdtsc());
+#else
+	return (0);
+#endif
+}
+
+static long	k_win(t_micro *m, long iters)
+{
+	long	sink;
+
+	sink = 0;
+	for (long i = 0; i < iters; i++)
+		sink += verifierGagnantDynamic(m->board, (i & 1) ? 'O' : 'X');
+	g_sink += sink;
+	return (iters);
+}
+
+static long	k_tie(t_micro *m, long iters)
+{
+	long	sink;
+
+	sink = 0;
+	for (long i = 0; i < iters; i++)
+		sink += verifierMatchNul(m->board);
+	g_sink += sink;
+	return (iters);
+}
+
+static long	k_init(t_micro *m, long iters)
+{
+	long	sink;
+
+	sink = 0;
+	for (long i = 0; i < iters; i++)
+	{
+		init_board(m->scratch);
+		sink += m->scratch->empty;
+	}
+	g_sink += sink;
+	return (iters);
+}
+
+static long	k_random(t_micro *m, long iters)
+{
+	long	sink;
+
+	sink = 0;
+	for (long i = 0; i < iters; i++)
+		sink += board_random_cell(m->board, &m->rng);
+	g_sink += sink;
+	return (iters);
+}
+
+//une operation par ligne lue ; iters passes sur le texte de la partie
+static long	k_parse(t_micro *m, long iters)
+{
+	t_history_line	line;
+	const char		*p;
+	const char		*end;
+	long			ops;
+
+	ops = 0;
+	end = m->text + m->text_len;
+	for (long i = 0; i < iters; i++)
+	{
+		p = m->text;
+		while (p < end)
+		{
+			p = parse_history_line(p, end, &line);
+			g_sink += line.type;
+			ops++;
+		}
+	}
+	return (ops);
+}
+
+//allocations de m->bytes octets, l'arene est rendue a intervalles reguliers
+static long	k_alloc(t_micro *m, long iters)
+{
+	t_arena_mark	mark;
+
+	mark = arena_mark(m->arena);
+	for (long i = 0; i < iters; i++)
+	{
+		g_sink += (long)(uintptr_t)arena_alloc(m->arena, m->bytes) & 1;
+		if ((i + 1) % MICRO_RELEASE == 0)
+			arena_release(m->arena, mark);
+	}
+	arena_release(m->arena, mark);
+	return (iters);
+}
+
+//une operation par plateau du lot
+static long	k_batch(t_micro *m, long iters)
+{
+	for (long i = 0; i < iters; i++)
+	{
+		win_batch_impl(m->impl, m->board->masks, &m->soa, m->wins, m->ties);
+		g_sink += (long)(m->wins[0] & 1);
+	}
+	return (iters * m->soa.nb);
+}
+
+static int	cmp_double(const void *a, const void *b)
+{
+	double	x;
+	double	y;
+
+	x = *(const double *)a;
+	y = *(const double *)b;
+	return ((x > y) - (x < y));
+}
+
+//mesure un noyau : echauffement, MICRO_REPS repetitions d'environ MICRO_TARGET_NS chacune
+//puis une ligne JSON (le debut de la ligne, la description du cas, est deja ecrit)
+static void	micro_run(t_micro *m, t_kernel kernel)
+{
+	double		ns[MICRO_REPS];
+	double		cycles[MICRO_REPS];
+	uint64_t	t0;
+	uint64_t	c0;
+	long		iters;
+	long		ops;
+
+	kernel(m, MICRO_WARMUP); //caches, predicteurs et pages de l'arene deja chauds
+	t0 = micro_ns();
+	kernel(m, MICRO_WARMUP);
+	t0 = micro_ns() - t0;
+	iters = t0 > 0 ? (long)((double)MICRO_TARGET_NS * MICRO_WARMUP / (double)t0) : MICRO_WARMUP;
+	if (iters < 1)
+		iters = 1;
+	for (int r = 0; r < MICRO_REPS; r++)
+	{
+		t0 = micro_ns();
+		c0 = micro_cycles();
+		ops = kernel(m, iters);
+		c0 = micro_cycles() - c0;
+		t0 = micro_ns() - t0;
+		ns[r] = (double)t0 / (double)ops;
+		cycles[r] = (double)c0 / (double)ops;
+	}
+	qsort(ns, MICRO_REPS, sizeof(double), cmp_double);
+	qsort(cycles, MICRO_REPS, sizeof(double), cmp_double);
+	printf("\"ops\":%ld,\"ns_per_op\":%.3f,\"ns_min\":%.3f,", ops, ns[MICRO_REPS / 2], ns[0]);
+	if (micro_cycles() == 0)
+		printf("\"cycles_per_op\":null}");
+	else
+		printf("\"cycles_per_op\":%.2f}", cycles[MICRO_REPS / 2]);
+}
+
+//position de nb_moves coups tires avec une graine fixe, en evitant les coups gagnants quand c'est possible :
+//les verifications parcourent alors toutes les lignes, comme pendant une partie
+static void	micro_position(t_board *b, int size, int nb_moves, t_rng *rng)
+{
+	int	cell;
+	int	player;
+	int	tries;
+
+	b->size = size;
+	init_board(b);
+	while (size * size - b->empty < nb_moves)
+	{
+		player = (size * size - b->empty) & 1;
+		tries = b->empty * 4;
+		while (1)
+		{
+			cell = board_random_cell(b, rng);
+			board_play(b, cell, player);
+			if (b->winner == -1 || --tries == 0)
+				break ;
+			board_undo(b, cell, player);
+		}
+	}
+}
+
+//lot de plateaux autour de nb_moves coups (un sur deux en a un de plus), sans eviter les victoires,
+//et le resultat attendu de verifierGagnantDynamic et verifierMatchNul pour chacun
+static void	micro_block(t_micro *m, uint64_t *soa, int size, int nb_moves, uint64_t *expect)
+{
+	t_board	*b;
+	int		n;
+	int		cell;
+
+	b = m->scratch;
+	b->size = size;
+	memset(expect, 0, sizeof(uint64_t) * 2 * (MICRO_BLOCK / 64));
+	for (int i = 0; i < MICRO_BLOCK; i++)
+	{
+		init_board(b);
+		n = nb_moves + (i & 1) < size * size ? nb_moves + (i & 1) : size * size;
+		while (size * size - b->empty < n)
+		{
+			cell = board_random_cell(b, &m->rng);
+			board_play(b, cell, (size * size - b->empty) & 1);
+		}
+		soa[i] = (uint64_t)b->bits[i & 1]; //on verifie X sur les plateaux pairs, O sur les impairs
+		soa[MICRO_BLOCK + i] = (uint64_t)(b->bits[i & 1] >> 64);
+		soa[2 * MICRO_BLOCK + i] = (uint64_t)(b->bits[0] | b->bits[1]);
+		soa[3 * MICRO_BLOCK + i] = (uint64_t)((b->bits[0] | b->bits[1]) >> 64);
+		if (verifierGagnantDynamic(b, (i & 1) ? 'O' : 'X'))
+			expect[i >> 6] |= (uint64_t)1 << (i & 63);
+		if (verifierMatchNul(b))
+			expect[MICRO_BLOCK / 64 + (i >> 6)] |= (uint64_t)1 << (i & 63);
+	}
+}
+
+//chaque version de win_batch que le processeur sait executer doit rendre exactement les memes bits
+//que verifierGagnantDynamic et verifierMatchNul : sinon la mesure n'a pas de sens, on s'arrete
+static void	micro_check_batch(t_micro *m, const uint64_t *expect, int size, int state)
+{
+	for (int impl = WINBATCH_SCALAR; impl <= win_batch_best(); impl++)
+	{
+		win_batch_impl(impl, m->board->masks, &m->soa, m->wins, m->ties);
+		if (memcmp(m->wins, expect, sizeof(uint64_t) * (MICRO_BLOCK / 64)) != 0
+			|| memcmp(m->ties, expect + MICRO_BLOCK / 64,
+				sizeof(uint64_t) * (MICRO_BLOCK / 64)) != 0)
+		{
+			fprintf(stderr, "%s disagrees with verifierGagnantDynamic on %dx%d (%s)\n",
+				g_impls[impl], size, size, g_states[state]);
+			exit(EXIT_FAILURE);
+		}
+	}
+}
+
+//la partie de la position au format texte de l'historique
+static size_t	micro_text(const t_board *b, char *text)
+{
+	size_t	len;
+	int		played;
+
+	played = b->size * b->size - b->empty;
+	len = (size_t)snprintf(text, MICRO_TEXT, "size:%d\n", b->size);
+	for (int i = 0; i < played; i++)
+		len += (size_t)snprintf(text + len, MICRO_TEXT - len, "Player %d: (%d, %d)\n", i % 2 + 1,
+				b->moves[i] / b->size + 1, b->moves[i] % b->size + 1);
+	len += (size_t)snprintf(text + len, MICRO_TEXT - len, "Tie\n");
+	return (len);
+}
+
+//bench_micro : chaque fonction chaude seule, sur des plateaux fixes de 3x3 a 9x9
+//une ligne JSON par mesure, a comparer d'un commit a l'autre (make -s bench-micro > avant.json)
+int	main(void)
+{
+	static const char	*names[] = {"verifierGagnantDynamic", "verifierMatchNul",
+		"init_board", "board_random_cell", "parse_history_line"};
+	static const t_kernel	kernels[] = {k_win, k_tie, k_init, k_random, k_parse};
+	static const size_t	bytes[] = {16, 256, sizeof(t_board), 4096};
+	t_micro				m;
+	char				text[MICRO_TEXT];
+	int					first;
+	uint64_t			*soa;
+	uint64_t			*expect;
+
+	m.arena = arena_init(ARENA_CHUNK_SIZE);
+	if (m.arena == NULL)
+	{
+		fprintf(stderr, "Memory allocation failed\n");
+		return (EXIT_FAILURE);
+	}
+	m.board = (t_board *)arena_alloc(m.arena, sizeof(t_board));
+	m.scratch = (t_board *)arena_alloc(m.arena, sizeof(t_board));
+	m.text = text;
+	soa = (uint64_t *)arena_alloc(m.arena, sizeof(uint64_t) * 4 * MICRO_BLOCK);
+	expect = (uint64_t *)arena_alloc(m.arena, sizeof(uint64_t) * 2 * (MICRO_BLOCK / 64));
+	m.wins = (uint64_t *)arena_alloc(m.arena, sizeof(uint64_t) * (MICRO_BLOCK / 64));
+	m.ties = (uint64_t *)arena_alloc(m.arena, sizeof(uint64_t) * (MICRO_BLOCK / 64));
+	m.soa.lo = soa;
+	m.soa.hi = soa + MICRO_BLOCK;
+	m.soa.occ_lo = soa + 2 * MICRO_BLOCK;
+	m.soa.occ_hi = soa + 3 * MICRO_BLOCK;
+	m.soa.nb = MICRO_BLOCK;
+	printf("{\"reps\":%d,\"results\":[", MICRO_REPS);
+	first = 1;
+	for (int size = 3; size <= MAX_SIZE; size++)
+	{
+		for (int s = 0; s < 3; s++)
+		{
+			rng_seed(&m.rng, (uint64_t)(size * 3 + s)); //memes positions a chaque execution
+			micro_position(m.board, size, s == 0 ? 0 : s == 1 ? size * size / 2
+				: size * size - 1, &m.rng);
+			m.scratch->size = size;
+			m.text_len = micro_text(m.board, text);
+			for (int k = 0; k < 5; k++)
+			{
+				printf("%s\n{\"kernel\":\"%s\",\"size\":%d,\"state\":\"%s\",", first ? "" : ",",
+					names[k], size, g_states[s]);
+				first = 0;
+				micro_run(&m, kernels[k]);
+			}
+			micro_block(&m, soa, size, s == 0 ? 0 : s == 1 ? size * size / 2
+				: size * size - 1, expect);
+			micro_check_batch(&m, expect, size, s);
+			for (m.impl = WINBATCH_SCALAR; m.impl <= win_batch_best(); m.impl++)
+			{
+				printf(",\n{\"kernel\":\"%s\",\"size\":%d,\"state\":\"%s\",",
+					g_impls[m.impl], size, g_states[s]);
+				micro_run(&m, k_batch);
+			}
+		}
+	}
+	for (int i = 0; i < 4; i++)
+	{
+		m.bytes = bytes[i];
+		printf(",\n{\"kernel\":\"arena_alloc\",\"bytes\":%zu,", m.bytes);
+		micro_run(&m, k_alloc);
+	}
+	printf("\n]}\n");
+	arena_destroy(m.arena);
+	return (EXIT_SUCCESS);
+}
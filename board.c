@@ -0,0 +1,233 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tictactoe.h"
+
+static t_winmasks		g_winmasks[MAX_SIZE + 1]; //une table de lignes gagnantes par taille de plateau
+static pthread_once_t	g_winmasks_once = PTHREAD_ONCE_INIT;
+static uint64_t			g_zobrist[2][MAX_CELLS]; //cle aleatoire de chaque case pour chaque joueur
+
+//bit de la case (ligne, colonne) dans un plateau de taille size
+static t_bitboard	cell_bit(int size, int ligne, int colonne)
+{
+	return ((t_bitboard)1 << (ligne * size + colonne));
+}
+
+//calcul des lignes gagnantes d'une taille : horizontales, verticales et les deux diagonales
+static void	build_winmasks(t_winmasks *w, int size)
+{
+	int			dl[4] = {0, 1, 1, 1}; //deplacement en ligne pour chaque direction
+	int			dc[4] = {1, 0, 1, -1}; //deplacement en colonne pour chaque direction
+	t_bitboard	mask;
+	int			end_l;
+	int			end_c;
+	int			cell;
+
+	w->sequence = size == 3 ? 3 : 4;
+	w->nb_lines = 0;
+	w->full = 0;
+	for (int i = 0; i < size; i++)
+		for (int j = 0; j < size; j++)
+			w->full |= cell_bit(size, i, j);
+	for (int d = 0; d < 4; d++)
+	{
+		for (int i = 0; i < size; i++)
+		{
+			for (int j = 0; j < size; j++)
+			{
+				end_l = i + dl[d] * (w->sequence - 1);
+				end_c = j + dc[d] * (w->sequence - 1);
+				if (end_l < 0 || end_l >= size || end_c < 0 || end_c >= size)
+					continue ; //l'alignement sort du plateau
+				mask = 0;
+				for (int k = 0; k < w->sequence; k++)
+				{
+					cell = (i + dl[d] * k) * size + j + dc[d] * k;
+					mask |= (t_bitboard)1 << cell;
+					w->cell_lines[cell][w->cell_nb_lines[cell]++] = w->nb_lines; //la ligne passe par cette case
+				}
+				w->lines[w->nb_lines++] = mask;
+			}
+		}
+	}
+	for (int s = 0; s < NB_SYMMETRIES; s++)
+		for (int i = 0; i < size * size; i++)
+			w->sym[s][i] = (unsigned char)sym_cell(size, s, i / size, i % size);
+}
+
+static void	init_winmasks(void)
+{
+	uint64_t	state;
+
+	for (int size = 3; size <= MAX_SIZE; size++)
+		build_winmasks(&g_winmasks[size], size);
+	state = 0x7474745A4F4252ULL;
+	for (int p = 0; p < 2; p++)
+		for (int i = 0; i < MAX_CELLS; i++)
+			g_zobrist[p][i] = splitmix64(&state);
+}
+
+//renvoie la table des lignes gagnantes pour une taille (calculee une seule fois)
+const t_winmasks	*get_winmasks(int size)
+{
+	pthread_once(&g_winmasks_once, init_winmasks);
+	return (&g_winmasks[size]);
+}
+
+//initialisation du plateau de jeu
+void	init_board(t_board *board)
+{
+	board->masks = get_winmasks(board->size);
+	board->bits[0] = 0;
+	board->bits[1] = 0;
+	board->empty = board->size * board->size;
+	for (int i = 0; i < board->empty; i++)
+	{
+		board->free_cells[i] = (unsigned char)i;
+		board->free_pos[i] = (unsigned char)i;
+	}
+	board->last_move = -1;
+	board->winner = -1;
+	memset(board->hash, 0, sizeof(board->hash));
+	memset(board->line_count, 0, sizeof(board->line_count));
+}
+
+//joue un coup et met a jour les compteurs des seules lignes qui passent par la case : O(k)
+//renvoie 1 si le coup fait gagner le joueur
+int	board_play(t_board *board, int cell, int player)
+{
+	const t_winmasks	*w;
+	unsigned char		*count;
+	int					line;
+	int					last;
+
+	w = board->masks;
+	board->bits[player] |= (t_bitboard)1 << cell;
+	for (int s = 0; s < NB_SYMMETRIES; s++) //les 8 cles restent a jour pour la cle canonique
+		board->hash[s] ^= g_zobrist[player][w->sym[s][cell]];
+	board->moves[board->size * board->size - board->empty] = (unsigned char)cell;
+	board->empty--;
+	last = board->free_cells[board->empty]; //la derniere case libre prend la place de celle jouee
+	board->free_cells[board->free_pos[cell]] = last;
+	board->free_pos[last] = board->free_pos[cell];
+	board->last_move = cell;
+	count = board->line_count[player];
+	for (int i = 0; i < w->cell_nb_lines[cell]; i++)
+	{
+		line = w->cell_lines[cell][i];
+		if (++count[line] == w->sequence)
+			board->winner = player;
+	}
+	return (board->winner == player);
+}
+
+//annule le dernier coup joue (cell par player), pour la recherche
+//seul ce coup a pu faire gagner : la recherche ne continue jamais apres une victoire
+void	board_undo(t_board *board, int cell, int player)
+{
+	const t_winmasks	*w;
+	unsigned char		*count;
+	int					played;
+
+	w = board->masks;
+	board->bits[player] &= ~((t_bitboard)1 << cell);
+	for (int s = 0; s < NB_SYMMETRIES; s++)
+		board->hash[s] ^= g_zobrist[player][w->sym[s][cell]];
+	board->free_cells[board->empty] = (unsigned char)cell; //la case redevient libre, en fin de liste
+	board->free_pos[cell] = (unsigned char)board->empty;
+	board->empty++;
+	played = board->size * board->size - board->empty;
+	board->last_move = played > 0 ? board->moves[played - 1] : -1;
+	count = board->line_count[player];
+	for (int i = 0; i < w->cell_nb_lines[cell]; i++)
+		count[w->cell_lines[cell][i]]--;
+	if (board->winner == player)
+		board->winner = -1;
+}
+
+//case libre tiree au hasard : un tirage dans la liste des cases libres, quel que soit le remplissage
+//le generateur appartient a l'appelant, pour que chaque thread tire ses coups sans verrou
+int	board_random_cell(t_board *board, t_rng *rng)
+{
+	return (board->free_cells[rng_below(rng, (unsigned int)board->empty)]);
+}
+
+//renvoie le symbole de la case : 'X', 'O' ou ' '
+char	board_get(t_board *board, int ligne, int colonne)
+{
+	t_bitboard	bit;
+
+	bit = cell_bit(board->size, ligne, colonne);
+	if (board->bits[0] & bit)
+		return ('X');
+	if (board->bits[1] & bit)
+		return ('O');
+	return (' ');
+}
+
+//pose un symbole dans une case libre
+void	board_set(t_board *board, int ligne, int colonne, char symbole)
+{
+	board_play(board, ligne * board->size + colonne, symbole == 'X' ? 0 : 1);
+}
+
+//affichage du plateau de jeu
+void	print_board(t_board *board)
+{
+	int	i;
+	int	j;
+
+	i = 0;
+	while (i < board->size)
+	{
+		j = 0;
+		while (j < board->size)
+		{
+			putchar(' ');
+			putchar(board_get(board, i, j));
+			putchar(' ');
+			if (j < board->size - 1)
+				putchar('|');
+			j++;
+		}
+		putchar('\n');
+		if (i < board->size - 1)
+		{
+			j = 0;
+			while (j < board->size)
+			{
+				printf("---");
+				if (j < board->size - 1)
+					putchar('+');
+				j++;
+			}
+			putchar('\n');
+		}
+		i++;
+	}
+	putchar('\n');
+}
+
+//fonction de verification de victoire : un ET par ligne gagnante
+int	verifierGagnantDynamic(t_board *board, char symbole)
+{
+	const t_winmasks	*w;
+	t_bitboard			b;
+
+	w = board->masks;
+	b = board->bits[symbole == 'X' ? 0 : 1];
+	for (int i = 0; i < w->nb_lines; i++)
+	{
+		if ((b & w->lines[i]) == w->lines[i])
+			return (1);
+	}
+	return (0);
+}
+
+//fonction de verification de match nul
+int	verifierMatchNul(t_board *board)
+{
+	return ((board->bits[0] | board->bits[1]) == board->masks->full);
+} //verifie si il y a des cases de libres sur le plateau
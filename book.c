@@ -0,0 +1,101 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "tictactoe.h"
+
+static t_book			g_books[MAX_SIZE + 1]; //un livre par taille, projete une seule fois
+static atomic_int		g_book_loaded[MAX_SIZE + 1];
+static pthread_mutex_t	g_book_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+//projette le livre d'une taille ; sans fichier valide le livre reste vide
+static void	book_load(t_book *book, int size)
+{
+	char				path[128];
+	int					fd;
+	struct stat			st;
+	const t_book_header	*h;
+
+	snprintf(path, sizeof(path), "%s/book_%d.tttbook", BOOK_DIR, size);
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return ;
+	if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(t_book_header))
+	{
+		book->map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		if (book->map == MAP_FAILED)
+			book->map = NULL;
+		book->len = (size_t)st.st_size;
+	}
+	close(fd);
+	if (book->map == NULL)
+		return ;
+	h = (const t_book_header *)book->map;
+	if (memcmp(h->magic, BOOK_MAGIC, sizeof(h->magic)) != 0
+		|| h->version != BOOK_VERSION || h->size != (uint32_t)size
+		|| book->len != sizeof(*h) + h->nb_entries * sizeof(t_book_entry))
+	{
+		fprintf(stderr, "Ignoring invalid opening book %s\n", path);
+		munmap(book->map, book->len);
+		book->map = NULL;
+		return ;
+	}
+	book->entries = (const t_book_entry *)(h + 1);
+	book->nb_entries = (long)h->nb_entries;
+}
+
+//livre d'une taille, projete a la premiere demande ; NULL si il n'y en a pas
+const t_book	*book_get(int size)
+{
+	if (!atomic_load_explicit(&g_book_loaded[size], memory_order_acquire))
+	{
+		pthread_mutex_lock(&g_book_mutex);
+		if (!atomic_load(&g_book_loaded[size]))
+		{
+			book_load(&g_books[size], size);
+			atomic_store_explicit(&g_book_loaded[size], 1, memory_order_release);
+		}
+		pthread_mutex_unlock(&g_book_mutex);
+	}
+	if (g_books[size].nb_entries == 0)
+		return (NULL);
+	return (&g_books[size]);
+}
+
+static int	cmp_book_key(const void *key, const void *entry)
+{
+	uint64_t	k;
+
+	k = *(const uint64_t *)key;
+	if (k < ((const t_book_entry *)entry)->key)
+		return (-1);
+	return (k > ((const t_book_entry *)entry)->key);
+}
+
+//coup du livre pour player dans cette position, -1 si elle n'y est pas
+//recherche dichotomique directement dans le fichier projete
+int	book_move(t_board *board, int player)
+{
+	const t_book		*book;
+	const t_book_entry	*e;
+	uint64_t			key;
+	int					sym;
+	int					cell;
+
+	book = book_get(board->size);
+	if (book == NULL)
+		return (-1);
+	key = search_key(board, player, &sym);
+	e = bsearch(&key, book->entries, (size_t)book->nb_entries,
+			sizeof(t_book_entry), cmp_book_key);
+	if (e == NULL || e->move >= board->size * board->size)
+		return (-1);
+	cell = board->masks->sym[sym_inverse(sym)][e->move]; //retour du repere canonique au plateau
+	if ((board->bits[0] | board->bits[1]) & ((t_bitboard)1 << cell))
+		return (-1);
+	return (cell);
+}
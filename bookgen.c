@@ -0,0 +1,449 @@
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "tictactoe.h"
+
+#define BOOK_MIN_GAMES 8 //parties necessaires pour qu'un coup de l'historique entre dans le livre
+#define BOOK_SOURCE_SEARCH 0
+#define BOOK_SOURCE_HISTORY 1
+
+//position a mettre dans le livre : les coups qui y menent depuis le plateau vide
+typedef struct
+{
+	uint64_t		key;
+	unsigned char	first; //joueur qui a commence
+	unsigned char	nb_moves;
+	unsigned char	moves[BOOK_MAX_DEPTH];
+}					t_book_pos;
+
+//positions distinctes (a une symetrie pres) des premiers coups
+typedef struct
+{
+	t_book_pos		*pos;
+	long			nb;
+	long			cap;
+	uint64_t		*set; //cles deja vues (adressage ouvert, 0 = case vide)
+	size_t			set_mask;
+	long			set_nb;
+	int				has_zero; //la cle 0 a ete vue
+}					t_book_gen;
+
+//travail partage par les threads de recherche
+typedef struct
+{
+	t_book_gen		*gen;
+	t_book_entry	*entries;
+	t_tt			*tt;
+	int				size;
+	atomic_long		next;
+}					t_book_work;
+
+typedef struct
+{
+	pthread_t		thread;
+	t_book_work		*work;
+	t_search		search;
+}					t_book_thread;
+
+//un coup joue dans une partie de l'historique et son resultat pour le joueur qui l'a joue
+typedef struct
+{
+	uint64_t		key;
+	unsigned char	move;
+	signed char		result; //1 gagne, 0 nul, -1 perdu
+}					t_book_sample;
+
+typedef struct
+{
+	t_book_sample	*s;
+	long			nb;
+	long			cap;
+}					t_book_samples;
+
+static void	*book_grow(void *p, long *cap, size_t elem)
+{
+	*cap = *cap ? *cap * 2 : 1024;
+	p = realloc(p, (size_t)*cap * elem);
+	if (p == NULL)
+	{
+		fprintf(stderr, "Out of memory while building the opening book\n");
+		exit(EXIT_FAILURE);
+	}
+	return (p);
+}
+
+//ajoute key aux cles vues, renvoie 1 si elle y etait deja
+static int	gen_seen(t_book_gen *g, uint64_t key)
+{
+	uint64_t	*old;
+	size_t		old_size;
+	size_t		i;
+
+	if (key == 0)
+	{
+		if (g->has_zero)
+			return (1);
+		g->has_zero = 1;
+		return (0);
+	}
+	if ((size_t)(g->set_nb + 1) * 2 > g->set_mask + 1) //table a moitie pleine : on double
+	{
+		old = g->set;
+		old_size = old ? g->set_mask + 1 : 0;
+		g->set_mask = old ? old_size * 2 - 1 : 4095;
+		g->set = calloc(g->set_mask + 1, sizeof(uint64_t));
+		if (g->set == NULL)
+		{
+			fprintf(stderr, "Out of memory while building the opening book\n");
+			exit(EXIT_FAILURE);
+		}
+		g->set_nb = 0;
+		for (size_t k = 0; k < old_size; k++)
+			if (old[k])
+				gen_seen(g, old[k]);
+		free(old);
+	}
+	i = key & g->set_mask;
+	while (g->set[i] != 0)
+	{
+		if (g->set[i] == key)
+			return (1);
+		i = (i + 1) & g->set_mask;
+	}
+	g->set[i] = key;
+	g->set_nb++;
+	return (0);
+}
+
+//parcours des depth premiers coups ; chaque position n'est gardee (et developpee) qu'une fois
+static void	gen_positions(t_book_gen *g, t_board *board, int player, int first,
+	int depth)
+{
+	t_book_pos	*p;
+	int			played;
+	int			sym;
+	uint64_t	key;
+
+	played = board->size * board->size - board->empty;
+	if (played >= depth || board->winner != -1 || board->empty == 0)
+		return ;
+	key = search_key(board, player, &sym);
+	if (gen_seen(g, key))
+		return ;
+	if (g->nb == g->cap)
+		g->pos = book_grow(g->pos, &g->cap, sizeof(t_book_pos));
+	p = &g->pos[g->nb++];
+	p->key = key;
+	p->first = (unsigned char)first;
+	p->nb_moves = (unsigned char)played;
+	memcpy(p->moves, board->moves, (size_t)played);
+	for (int cell = 0; cell < board->size * board->size; cell++)
+	{
+		if ((board->bits[0] | board->bits[1]) & ((t_bitboard)1 << cell))
+			continue ;
+		board_play(board, cell, player);
+		gen_positions(g, board, player ^ 1, first, depth);
+		board_undo(board, cell, player);
+	}
+}
+
+//thread de generation : cherche le meilleur coup des positions prises a tour de role
+static void	*book_search_thread(void *arg)
+{
+	t_book_thread	*t;
+	t_book_work		*w;
+	t_book_pos		*p;
+	t_board			board;
+	long			i;
+	int				player;
+	int				cell;
+	int				sym;
+
+	t = (t_book_thread *)arg;
+	w = t->work;
+	while ((i = atomic_fetch_add(&w->next, 1)) < w->gen->nb)
+	{
+		p = &w->gen->pos[i];
+		board.size = w->size;
+		init_board(&board);
+		player = p->first;
+		for (int k = 0; k < p->nb_moves; k++)
+		{
+			board_play(&board, p->moves[k], player);
+			player ^= 1;
+		}
+		cell = search_best_move(&t->search, &board, player);
+		search_key(&board, player, &sym);
+		w->entries[i].key = p->key;
+		w->entries[i].score = t->search.score;
+		w->entries[i].move = board.masks->sym[sym][cell]; //range dans le repere canonique
+	}
+	return (NULL);
+}
+
+static int	cmp_entry(const void *a, const void *b)
+{
+	uint64_t	ka;
+	uint64_t	kb;
+
+	ka = ((const t_book_entry *)a)->key;
+	kb = ((const t_book_entry *)b)->key;
+	return ((ka > kb) - (ka < kb));
+}
+
+//livre par la recherche : toutes les positions des depth premiers coups, les deux joueurs pouvant
+//commencer, sont cherchees en parallele avec une table de transposition commune
+static t_book_entry	*book_from_search(t_arena *arena, int size, int depth,
+	long *nb)
+{
+	t_book_gen		gen;
+	t_book_work		work;
+	t_book_thread	*threads;
+	t_board			board;
+	int				nb_threads;
+
+	memset(&gen, 0, sizeof(gen));
+	for (int first = 0; first < 2; first++)
+	{
+		board.size = size;
+		init_board(&board);
+		gen_positions(&gen, &board, first, first, depth);
+	}
+	free(gen.set);
+	work.gen = &gen;
+	work.size = size;
+	work.entries = calloc((size_t)gen.nb + 1, sizeof(t_book_entry));
+	work.tt = (t_tt *)arena_alloc(arena, sizeof(t_tt));
+	tt_init(arena, work.tt, 0);
+	atomic_init(&work.next, 0);
+	nb_threads = default_nb_workers();
+	threads = (t_book_thread *)arena_alloc(arena, sizeof(t_book_thread) * nb_threads);
+	for (int i = 0; i < nb_threads; i++)
+	{
+		threads[i].work = &work;
+		search_init(&threads[i].search, AI_LEVEL_HARD, work.tt, (uint64_t)i);
+		pthread_create(&threads[i].thread, NULL, book_search_thread, threads + i);
+	}
+	for (int i = 0; i < nb_threads; i++)
+		pthread_join(threads[i].thread, NULL);
+	free(gen.pos);
+	*nb = gen.nb;
+	return (work.entries);
+}
+
+//rejoue les depth premiers coups d'une partie de l'historique et note chacun avec le resultat
+static void	sample_record(t_book_samples *out, const t_log_record *rec, int depth)
+{
+	t_board		board;
+	int			player;
+	int			sym;
+	t_bitboard	bit;
+
+	board.size = rec->size;
+	init_board(&board);
+	player = rec->first_player;
+	for (int k = 0; k < depth && k < rec->nb_moves && board.winner == -1; k++)
+	{
+		bit = (t_bitboard)1 << rec->moves[k];
+		if ((board.bits[0] | board.bits[1]) & bit)
+			return ; //partie incoherente : on s'arrete la
+		if (out->nb == out->cap)
+			out->s = book_grow(out->s, &out->cap, sizeof(t_book_sample));
+		out->s[out->nb].key = search_key(&board, player, &sym);
+		out->s[out->nb].move = board.masks->sym[sym][rec->moves[k]];
+		out->s[out->nb++].result = rec->result == LOG_RESULT_TIE ? 0
+			: rec->result == player ? 1 : -1;
+		board_play(&board, rec->moves[k], player);
+		player ^= 1;
+	}
+}
+
+//toutes les parties de la taille dans un segment du journal
+static void	sample_log(t_book_samples *out, const char *path, int size, int depth)
+{
+	int					fd;
+	struct stat			st;
+	unsigned char		*buf;
+	const unsigned char	*p;
+	const unsigned char	*end;
+	t_log_record		rec;
+	size_t				n;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return ;
+	buf = NULL;
+	if (fstat(fd, &st) == 0 && st.st_size > 0)
+		buf = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (buf == NULL || buf == MAP_FAILED)
+		return ;
+	if (gamelog_records(buf, (size_t)st.st_size, &p, &end) >= -1)
+	{
+		while (p < end && (n = gamelog_parse(p, (size_t)(end - p), &rec)) > 0)
+		{
+			if (rec.size == size)
+				sample_record(out, &rec, depth);
+			p += n;
+		}
+	}
+	munmap(buf, (size_t)st.st_size);
+}
+
+static int	cmp_sample(const void *a, const void *b)
+{
+	const t_book_sample	*sa;
+	const t_book_sample	*sb;
+
+	sa = (const t_book_sample *)a;
+	sb = (const t_book_sample *)b;
+	if (sa->key != sb->key)
+		return ((sa->key > sb->key) - (sa->key < sb->key));
+	return ((int)sa->move - (int)sb->move);
+}
+
+//livre par l'historique : pour chaque position, le coup au meilleur resultat moyen
+//parmi ceux joues au moins BOOK_MIN_GAMES fois dans les journaux de ./history
+static t_book_entry	*book_from_history(int size, int depth, long *nb)
+{
+	t_book_samples	samples;
+	t_book_entry	*entries;
+	DIR				*d;
+	struct dirent	*ent;
+	char			path[512];
+	long			i;
+	long			j;
+	long			games;
+	long			sum;
+
+	memset(&samples, 0, sizeof(samples));
+	d = opendir("./history");
+	if (d == NULL)
+	{
+		fprintf(stderr, "Could not open the history directory.\n");
+		exit(EXIT_FAILURE);
+	}
+	while ((ent = readdir(d)) != NULL)
+	{
+		if (strstr(ent->d_name, LOG_EXTENSION) == NULL)
+			continue ;
+		snprintf(path, sizeof(path), "./history/%s", ent->d_name);
+		sample_log(&samples, path, size, depth);
+	}
+	closedir(d);
+	qsort(samples.s, (size_t)samples.nb, sizeof(t_book_sample), cmp_sample);
+	entries = calloc((size_t)samples.nb + 1, sizeof(t_book_entry));
+	*nb = 0;
+	for (i = 0; i < samples.nb; i = j)
+	{
+		games = 0;
+		sum = 0;
+		for (j = i; j < samples.nb && samples.s[j].key == samples.s[i].key
+			&& samples.s[j].move == samples.s[i].move; j++)
+		{
+			games++;
+			sum += samples.s[j].result;
+		}
+		if (games < BOOK_MIN_GAMES)
+			continue ;
+		if (*nb > 0 && entries[*nb - 1].key == samples.s[i].key) //meme position : on garde le meilleur coup
+		{
+			if (sum * 1000 / games > entries[*nb - 1].score)
+			{
+				entries[*nb - 1].score = (int32_t)(sum * 1000 / games);
+				entries[*nb - 1].move = samples.s[i].move;
+			}
+			continue ;
+		}
+		entries[*nb].key = samples.s[i].key;
+		entries[*nb].score = (int32_t)(sum * 1000 / games); //resultat moyen en milliemes
+		entries[(*nb)++].move = samples.s[i].move;
+	}
+	free(samples.s);
+	return (entries);
+}
+
+//ecrit le livre trie dans un fichier temporaire puis le renomme
+static void	book_write(int size, int depth, int source, t_book_entry *entries,
+	long nb)
+{
+	t_book_header	h;
+	char			path[128];
+	char			tmp[160];
+	FILE			*fp;
+
+	qsort(entries, (size_t)nb, sizeof(t_book_entry), cmp_entry);
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, BOOK_MAGIC, sizeof(h.magic));
+	h.version = BOOK_VERSION;
+	h.size = (uint32_t)size;
+	h.depth = (uint32_t)depth;
+	h.source = (uint32_t)source;
+	h.nb_entries = (uint64_t)nb;
+	mkdir(BOOK_DIR, 0755);
+	snprintf(path, sizeof(path), "%s/book_%d.tttbook", BOOK_DIR, size);
+	snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+	fp = fopen(tmp, "wb");
+	if (fp == NULL)
+	{
+		fprintf(stderr, "Failed to open %s for writing\n", tmp);
+		exit(EXIT_FAILURE);
+	}
+	if (fwrite(&h, sizeof(h), 1, fp) != 1
+		|| fwrite(entries, sizeof(t_book_entry), (size_t)nb, fp) != (size_t)nb)
+	{
+		fprintf(stderr, "Failed to write %s\n", tmp);
+		exit(EXIT_FAILURE);
+	}
+	fclose(fp);
+	adjust_file_ownership(tmp);
+	rename(tmp, path);
+	printf("Book %dx%d: %ld positions up to move %d (%s) written to %s\n", size,
+		size, nb, depth, source == BOOK_SOURCE_SEARCH ? "search" : "history", path);
+}
+
+//./tictactoe book [taille|all] [profondeur] [search|history]
+//genere le livre d'ouvertures de chaque taille demandee
+int	book_command(t_arena *arena, int argc, char **argv)
+{
+	t_book_entry	*entries;
+	long			nb;
+	int				first;
+	int				last;
+	int				depth;
+	int				source;
+
+	first = 3;
+	last = MAX_SIZE;
+	if (argc > 0 && strcmp(argv[0], "all") != 0)
+	{
+		first = atoi(argv[0]);
+		last = first;
+	}
+	depth = argc > 1 ? atoi(argv[1]) : 2;
+	source = argc > 2 && strcmp(argv[2], "history") == 0 ? BOOK_SOURCE_HISTORY
+		: BOOK_SOURCE_SEARCH;
+	if (first < 3 || first > MAX_SIZE || depth < 1 || depth > BOOK_MAX_DEPTH
+		|| (argc > 2 && source == BOOK_SOURCE_SEARCH && strcmp(argv[2], "search") != 0))
+	{
+		fprintf(stderr, "usage: tictactoe book [3-9|all] [depth 1-%d] [search|history]\n",
+			BOOK_MAX_DEPTH);
+		return (EXIT_FAILURE);
+	}
+	for (int size = first; size <= last; size++)
+	{
+		if (source == BOOK_SOURCE_SEARCH)
+			entries = book_from_search(arena, size, depth, &nb);
+		else
+			entries = book_from_history(size, depth, &nb);
+		book_write(size, depth, source, entries, nb);
+		free(entries);
+	}
+	return (EXIT_SUCCESS);
+}
@@ -0,0 +1,302 @@
+#include <fcntl.h>
+#include <pwd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+
+#include "tictactoe.h"
+
+void adjust_file_ownership(const char* filename) { //fixbug lors du changement de politique il faut les droits admin, car quand on ouvre des fichiers, il y en a en haute priorite
+    struct passwd *pw = getpwuid(getuid());
+    if (pw == NULL) {
+        perror("getpwuid");
+        exit(EXIT_FAILURE);
+    }
+    uid_t user_id = pw->pw_uid;
+    gid_t group_id = pw->pw_gid;
+
+    if (chown(filename, user_id, group_id) < 0) {
+        perror("chown");
+        exit(EXIT_FAILURE);
+    }
+}
+
+//ecrit tout le tampon dans le fichier (write peut ecrire moins que demande)
+static void	write_all(int fd, const void *data, size_t len)
+{
+	const unsigned char	*p;
+	ssize_t				n;
+
+	p = (const unsigned char *)data;
+	while (len > 0)
+	{
+		n = write(fd, p, len);
+		if (n < 0)
+		{
+			perror("write");
+			exit(EXIT_FAILURE);
+		}
+		p += n;
+		len -= (size_t)n;
+	}
+}
+
+//vide le tampon du journal dans le segment
+static void	gamelog_flush(t_gamelog *log)
+{
+	if (log->buf_len == 0)
+		return ;
+	PROF_BEGIN(t_write);
+	write_all(log->fd, log->buf, log->buf_len);
+	PROF_END(PROF_LOG_WRITE, t_write);
+	log->buf_len = 0;
+}
+
+//ouvre le segment suivant et ecrit son en-tete
+static void	gamelog_open_segment(t_gamelog *log)
+{
+	t_log_header	header;
+
+	snprintf(log->path, sizeof(log->path), "./history/games_%ld_%d_%d_%d%s",
+		log->stamp, (int)getpid(), log->writer_id, log->seq, LOG_EXTENSION);
+	log->fd = open(log->path, O_WRONLY | O_CREAT | O_EXCL, 0644);
+	if (log->fd < 0)
+	{
+		fprintf(stderr, "Failed to open file for writing\n");
+		exit(EXIT_FAILURE);
+	}
+	adjust_file_ownership(log->path); //une seule fois par segment
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, LOG_MAGIC, sizeof(header.magic));
+	header.version = LOG_VERSION;
+	header.header_size = sizeof(header);
+	write_all(log->fd, &header, sizeof(header));
+	log->offset = sizeof(header);
+	log->nb_records = 0;
+	log->seq++;
+}
+
+//ferme le segment courant : tampon, index des offsets puis pied de page
+static void	gamelog_close_segment(t_gamelog *log)
+{
+	t_log_footer	footer;
+
+	gamelog_flush(log);
+	footer.nb_records = log->nb_records;
+	footer.nb_index = (log->nb_records + LOG_INDEX_STRIDE - 1) / LOG_INDEX_STRIDE;
+	footer.stride = LOG_INDEX_STRIDE;
+	memcpy(footer.magic, LOG_FOOTER_MAGIC, sizeof(footer.magic));
+	write_all(log->fd, log->index, sizeof(uint64_t) * footer.nb_index);
+	write_all(log->fd, &footer, sizeof(footer));
+	close(log->fd);
+	log->fd = -1;
+}
+
+//ouvre un journal ; chaque journal du processus a son numero pour que les noms ne se croisent pas
+void	gamelog_open(t_gamelog *log)
+{
+	static atomic_int	next_writer = 0;
+
+	log->writer_id = atomic_fetch_add(&next_writer, 1);
+	log->stamp = (long)time(NULL);
+	log->seq = 0;
+	log->buf_len = 0;
+	gamelog_open_segment(log);
+}
+
+//encode une partie terminee : taille, premier joueur, resultat puis les cases jouees
+//result vaut 0 ou 1 pour le joueur gagnant, LOG_RESULT_TIE pour un nul ; renvoie la taille ecrite
+size_t	gamelog_encode(t_board *board, int first_player, int result,
+	unsigned char *rec)
+{
+	int	nb_moves;
+
+	nb_moves = board->size * board->size - board->empty;
+	rec[0] = (unsigned char)board->size;
+	rec[1] = (unsigned char)first_player;
+	rec[2] = (unsigned char)result;
+	rec[3] = (unsigned char)nb_moves;
+	memcpy(rec + LOG_RECORD_HEADER, board->moves, nb_moves);
+	return (LOG_RECORD_HEADER + (size_t)nb_moves);
+}
+
+//encode une partie sans ses coups : ils se rejouent a partir de la graine et des niveaux des IA
+//seules les parties entre IA aleatoires se rejouent a coup sur, les autres dependent de la table partagee
+size_t	gamelog_encode_seed(t_board *board, int first_player, int result,
+	const t_log_seed *seed, unsigned char *rec)
+{
+	rec[0] = (unsigned char)board->size;
+	rec[1] = (unsigned char)(first_player | LOG_SEED_FLAG);
+	rec[2] = (unsigned char)result;
+	rec[3] = (unsigned char)(board->size * board->size - board->empty);
+	rec[4] = seed->levels[0];
+	rec[5] = seed->levels[1];
+	memcpy(rec + 6, &seed->seed, sizeof(seed->seed));
+	return (LOG_SEED_RECORD);
+}
+
+//ajoute une partie deja encodee au segment courant
+void	gamelog_append_raw(t_gamelog *log, const unsigned char *rec, size_t len)
+{
+	if (log->nb_records == LOG_SEGMENT_RECORDS)
+	{
+		gamelog_close_segment(log); //segment plein : on passe au suivant
+		gamelog_open_segment(log);
+	}
+	if (log->buf_len + len > LOG_BUFFER_SIZE)
+		gamelog_flush(log);
+	if (log->nb_records % LOG_INDEX_STRIDE == 0)
+		log->index[log->nb_records / LOG_INDEX_STRIDE] = log->offset;
+	memcpy(log->buf + log->buf_len, rec, len);
+	log->buf_len += len;
+	log->offset += len;
+	log->nb_records++;
+}
+
+//ajoute une partie terminee au journal
+void	gamelog_append(t_gamelog *log, t_board *board, int first_player,
+	int result)
+{
+	unsigned char	rec[LOG_RECORD_MAX];
+
+	gamelog_append_raw(log, rec, gamelog_encode(board, first_player, result,
+			rec));
+}
+
+//vide le tampon dans le segment courant sans le fermer
+void	gamelog_sync(t_gamelog *log)
+{
+	if (log->fd >= 0)
+		gamelog_flush(log);
+}
+
+//ferme le journal en ecrivant le dernier segment
+void	gamelog_close(t_gamelog *log)
+{
+	if (log->fd >= 0)
+		gamelog_close_segment(log);
+}
+
+//rejoue une partie rangee par sa graine, comme ia_play_move : un tirage par coup
+//renvoie 0 si la partie rejouee ne finit pas comme celle qui a ete rangee
+static int	gamelog_replay(t_log_record *rec)
+{
+	t_board	board;
+	t_rng	rng;
+	int		player;
+
+	board.size = rec->size;
+	init_board(&board);
+	rng_seed(&rng, rec->seed);
+	player = rec->first_player;
+	while (board.winner == -1 && board.empty > 0)
+	{
+		board_play(&board, board_random_cell(&board, &rng), player);
+		player ^= 1;
+	}
+	memcpy(rec->replay, board.moves, (size_t)rec->nb_moves);
+	rec->moves = rec->replay;
+	return (board.size * board.size - board.empty == rec->nb_moves
+		&& (board.winner == -1 ? LOG_RESULT_TIE : board.winner) == rec->result);
+}
+
+//lecture d'une partie a l'adresse p : renvoie sa taille en octets, 0 si elle est invalide
+//une partie rangee par sa graine est rejouee pour retrouver ses coups
+size_t	gamelog_parse(const unsigned char *p, size_t len, t_log_record *rec)
+{
+	int	cells;
+
+	if (len < LOG_RECORD_HEADER)
+		return (0);
+	rec->size = p[0];
+	rec->first_player = p[1] & ~LOG_SEED_FLAG;
+	rec->seeded = (p[1] & LOG_SEED_FLAG) != 0;
+	rec->result = p[2];
+	rec->nb_moves = p[3];
+	rec->moves = p + LOG_RECORD_HEADER;
+	if (rec->seeded)
+	{
+		if (len < LOG_SEED_RECORD || p[4] != AI_LEVEL_RANDOM || p[5] != AI_LEVEL_RANDOM)
+			return (0); //seules les parties aleatoires se rejouent
+		memcpy(&rec->seed, p + 6, sizeof(rec->seed));
+		if (rec->size < 3 || rec->size > MAX_SIZE || rec->first_player > 1
+			|| rec->result > LOG_RESULT_TIE || rec->nb_moves > rec->size * rec->size
+			|| !gamelog_replay(rec))
+			return (0);
+		return (LOG_SEED_RECORD);
+	}
+	if (rec->size < 3 || rec->size > MAX_SIZE || rec->first_player > 1
+		|| rec->result > LOG_RESULT_TIE)
+		return (0);
+	cells = rec->size * rec->size;
+	if (rec->nb_moves > cells || len < (size_t)LOG_RECORD_HEADER + rec->nb_moves)
+		return (0);
+	for (int i = 0; i < rec->nb_moves; i++)
+		if (rec->moves[i] >= cells)
+			return (0);
+	return (LOG_RECORD_HEADER + rec->nb_moves);
+}
+
+//zone des parties d'un segment charge en memoire (sans en-tete ni index)
+//renvoie le nombre de parties annonce par le pied de page, -1 si le segment n'a pas ete ferme
+//et -2 si ce n'est pas un journal
+long	gamelog_records(const unsigned char *buf, size_t len,
+	const unsigned char **begin, const unsigned char **end)
+{
+	const t_log_header	*header;
+	t_log_footer		footer;
+	size_t				tail;
+
+	header = (const t_log_header *)buf;
+	if (len < sizeof(t_log_header)
+		|| memcmp(header->magic, LOG_MAGIC, sizeof(header->magic)) != 0
+		|| header->version != LOG_VERSION)
+		return (-2);
+	*begin = buf + header->header_size;
+	*end = buf + len;
+	if (len < header->header_size + sizeof(t_log_footer))
+		return (-1);
+	memcpy(&footer, buf + len - sizeof(footer), sizeof(footer));
+	if (memcmp(footer.magic, LOG_FOOTER_MAGIC, sizeof(footer.magic)) != 0)
+		return (-1); //segment en cours d'ecriture ou interrompu : on lit jusqu'au bout
+	tail = sizeof(footer) + sizeof(uint64_t) * (size_t)footer.nb_index;
+	if (len < header->header_size + tail)
+		return (-1);
+	*end = buf + len - tail;
+	return ((long)footer.nb_records);
+}
+
+//cherche la partie numero n (a partir de 0) d'un segment, en sautant directement au bon bloc
+//grace a l'index du pied de page quand le segment a ete ferme ; renvoie 0 si elle n'existe pas
+int	gamelog_find(const unsigned char *buf, size_t len, long n,
+	t_log_record *rec)
+{
+	const unsigned char	*p;
+	const unsigned char	*end;
+	long				nb;
+	uint64_t			offset;
+	size_t				size;
+
+	nb = gamelog_records(buf, len, &p, &end);
+	if (nb < -1 || n < 0 || (nb >= 0 && n >= nb))
+		return (0);
+	if (nb >= 0)
+	{
+		memcpy(&offset, end + sizeof(uint64_t) * (size_t)(n / LOG_INDEX_STRIDE),
+			sizeof(offset));
+		if (offset >= (uint64_t)(end - buf))
+			return (0);
+		p = buf + offset;
+		n %= LOG_INDEX_STRIDE;
+	}
+	while (p < end && (size = gamelog_parse(p, (size_t)(end - p), rec)) > 0)
+	{
+		if (n-- == 0)
+			return (1);
+		p += size;
+	}
+	return (0);
+}
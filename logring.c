@@ -0,0 +1,147 @@
+#include <stdatomic.h>
+#include <time.h>
+
+#include "tictactoe.h"
+
+#define LOG_FLUSH_MS 5 //delai maximal entre la premiere partie en attente et son ecriture
+#define LOG_PUSH_WAIT_NS 50000 //pause d'un producteur bloque quand la file est pleine
+
+static double	logring_now(void)
+{
+	struct timespec	ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((double)ts.tv_sec + (double)ts.tv_nsec / 1e9);
+}
+
+//ajoute une partie terminee dans la file, sans verrou ni appel systeme
+//seed non NULL : on ne range que la graine de la partie
+//renvoie 0 si la file etait pleine et que la partie a ete jetee
+int	logring_push(t_logring *ring, t_board *board, int first_player,
+	int result, const t_log_seed *seed)
+{
+	t_log_slot		*slot;
+	size_t			pos;
+	size_t			seq;
+	struct timespec	wait;
+
+	wait.tv_sec = 0;
+	wait.tv_nsec = LOG_PUSH_WAIT_NS;
+	pos = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+	while (1)
+	{
+		slot = &ring->slots[pos & (LOG_RING_SIZE - 1)];
+		seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+		if (seq == pos) //case libre : on essaie de la reserver
+		{
+			if (atomic_compare_exchange_weak_explicit(&ring->tail, &pos, pos + 1,
+					memory_order_relaxed, memory_order_relaxed))
+				break ;
+		}
+		else if (seq < pos) //case pas encore lue par l'ecrivain : la file est pleine
+		{
+			if (!ring->block)
+			{
+				atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+				return (0);
+			}
+			nanosleep(&wait, NULL); //on laisse le processeur a l'ecrivain au lieu de tourner
+			pos = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+		}
+		else
+			pos = atomic_load_explicit(&ring->tail, memory_order_relaxed); //un autre producteur a pris la case
+	}
+	if (seed != NULL)
+		slot->len = (unsigned char)gamelog_encode_seed(board, first_player,
+				result, seed, slot->rec);
+	else
+		slot->len = (unsigned char)gamelog_encode(board, first_player, result,
+				slot->rec);
+	atomic_store_explicit(&slot->seq, pos + 1, memory_order_release); //la case est prete pour l'ecrivain
+	return (1);
+}
+
+//vide tout ce qui est pret dans la file vers le tampon du journal, renvoie le nombre de parties lues
+static int	logring_drain(t_logring *ring)
+{
+	t_log_slot	*slot;
+	int			n;
+
+	n = 0;
+	while (1)
+	{
+		slot = &ring->slots[ring->head & (LOG_RING_SIZE - 1)];
+		if (atomic_load_explicit(&slot->seq, memory_order_acquire) != ring->head + 1)
+			break ;
+		gamelog_append_raw(ring->log, slot->rec, slot->len);
+		atomic_store_explicit(&slot->seq, ring->head + LOG_RING_SIZE,
+			memory_order_release); //la case est rendue aux producteurs
+		ring->head++;
+		n++;
+	}
+	return (n);
+}
+
+//thread ecrivain : regroupe les parties en gros write, et dort un peu quand la file est vide
+//le tampon part quand il est plein (dans gamelog_append_raw), quand sa plus vieille partie attend
+//depuis LOG_FLUSH_MS, ou a l'arret
+static void	*logring_thread(void *arg)
+{
+	t_logring		*ring;
+	struct timespec	pause;
+	double			pending; //date de la premiere partie encore dans le tampon, 0 si il est vide
+	int				n;
+
+	ring = (t_logring *)arg;
+#ifdef TTT_PROFILE
+	prof_attach(&ring->prof);
+#endif
+#ifdef TTT_TRACE
+	trace_attach(&ring->trace);
+#endif
+	pause.tv_sec = 0;
+	pause.tv_nsec = 200000;
+	pending = 0;
+	while (!atomic_load_explicit(&ring->stop, memory_order_acquire))
+	{
+		n = logring_drain(ring);
+		if (ring->log->buf_len == 0)
+			pending = 0; //rien en attente, ou le tampon plein vient d'etre ecrit
+		else if (pending == 0)
+			pending = logring_now();
+		else if (logring_now() - pending >= LOG_FLUSH_MS / 1000.0)
+		{
+			gamelog_sync(ring->log);
+			pending = 0;
+		}
+		if (n == 0)
+			nanosleep(&pause, NULL);
+	}
+	logring_drain(ring); //les producteurs ont fini : on vide la file avant de fermer
+	gamelog_close(ring->log);
+	return (NULL);
+}
+
+//prepare la file et lance le thread ecrivain avec son propre journal
+void	logring_start(t_arena *arena, t_logring *ring, int block)
+{
+	ring->slots = (t_log_slot *)arena_alloc(arena, sizeof(t_log_slot)
+			* LOG_RING_SIZE);
+	for (size_t i = 0; i < LOG_RING_SIZE; i++)
+		atomic_init(&ring->slots[i].seq, i);
+	atomic_init(&ring->tail, 0);
+	ring->head = 0;
+	atomic_init(&ring->dropped, 0);
+	atomic_init(&ring->stop, 0);
+	ring->block = block;
+	ring->log = (t_gamelog *)arena_alloc(arena, sizeof(t_gamelog));
+	gamelog_open(ring->log);
+	pthread_create(&ring->thread, NULL, logring_thread, (void *)ring);
+}
+
+//arrete le thread ecrivain apres avoir ecrit toutes les parties en attente
+void	logring_stop(t_logring *ring)
+{
+	atomic_store_explicit(&ring->stop, 1, memory_order_release);
+	pthread_join(ring->thread, NULL);
+}
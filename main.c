@@ -1,5 +1,4 @@
 
-#include <dirent.h>
 #include <pthread.h>
 #include <semaphore.h>
 #include <stdint.h>
@@ -10,229 +9,9 @@
 #include <unistd.h>
 #include <sys/types.h>
 #include <pwd.h>
+#include <stdatomic.h>
 
-#define SCHED_POLICY SCHED_FIFO
-//structure d'allocation custom ( par pool de mémoire )
-typedef struct s_arena //Partie de la mémoire que l'on va allouer pour le code (pool de mémoire)
-{
-	void			*buf; //Adresse vers la plage de mémoire qui va être allouée
-	size_t			buf_size; //taille de cette plage
-	size_t			prev_offset; //permet de réallouer pour le malloc (si on alloue un tableau de 100 octets, l'offset devient 100 et le nouvel espace mémoire que l'on va allouer sera buf+100)
-	size_t			curr_offset; //permet de réallouer pour le malloc 
-}					t_arena;
-
-//structure du plateau de jeu
-typedef struct
-{
-	char			**board; //tableau qui contient les cases du tictactoe
-	int				size; //taille du tableau
-}					t_board;
-
-//structure du jeu
-typedef struct //contient tous les elements necessaires pour nous permettre de jouer
-{
-	t_board			*board;//pointeur vers la structure qui contient le tableau
-	int				player_turn; //definit qui doit jouer
-	int				game_type; //définit le type de partie que l'on veut jouer
-	pthread_mutex_t	*mutex; //Ce qui permet de bloquer un thread, evite que les deux threads accèdent au même espace memoire
-	sem_t			*sem; //Permet de donner un ordre d execution dans les threads
-	pthread_t		thread[2]; //cree un tableau qui contient les adresses des 2 threads
-	t_arena			*arena;
-	int				done;
-	int				player1;
-	int				policy; //politique d ordonnancement
-}					t_game;
-
-//structure d'analyse des parties
-typedef struct
-{
-	int				**win_by_first_move; //on stocke les first move qui permettent de gagner dans un tableau pour les compter
-	int				**win_by_second_move; //on stocke les second move qui permettent de gagner dans un tableau pour les compter
-	int				win_by_first_player;
-	int				win_by_second_player;
-	int				tie;
-	int				nb_games;
-
-}					t_analyse;
-
-//declaration des prototypes
-
-void				*arena_init(size_t buffer_size);
-void				arena_reset(t_arena *a);
-void				*arena_alloc(t_arena *a, size_t size);
-void				arena_destroy(t_arena *a);
-void				set_game_mode(t_arena *a, t_game *game);
-void				print_board(t_board *board);
-void				set_boardsize(t_arena *arena, t_board *board);
-void				print_board(t_board *board);
-void				init_board(t_arena *arena, t_board *board);
-void				is_game_done(t_arena *arena, t_board *board, t_game *game);
-int					verifierMatchNul(char **plateau, int boardSize);
-int					verifierGagnantDynamic(char **plateau, char symbole,
-						int boardSize);
-void				play_one_turn(t_arena *arena, t_board *board, t_game *game);
-void				tourOrdinateur(t_board *board, t_game *game);
-void				init_game(t_arena *arena, t_game *game);
-void				*thread_IA1(void *arg);
-void				*thread_IA2(void *arg);
-
-//fonction d'allocation custom, memset custom
-static void	*arena_memset(void *s, int c, size_t n) //Toute une zone memoire pointee par s est initialisee a c
-{
-	size_t	i;
-
-	i = -1;
-	while (++i < n)
-		((unsigned char *)s)[i] = c;
-	return (s);
-}
-
-//fonctions d'allocation custom, alignement de la memoire
-static int	is_power_of_two(uintptr_t x)
-{
-	return ((x & (x - 1)) == 0);
-}
-
-static uintptr_t	align_forward(uintptr_t ptr, size_t align) //si l adresse est une puissance de 2, on est aligné, sinon, on trouve le prochain entier qui en est une
-{
-	uintptr_t	p;
-	uintptr_t	a;
-	uintptr_t	modulo;
-
-	if (!is_power_of_two(align))
-		exit(1);
-	p = ptr;
-	a = (uintptr_t)align;
-	modulo = p % a;
-	if (modulo != 0)
-		p += a - modulo;
-	return (p);
-}
-
-//fonction d'allocation custom, re-allocation de la mémoire
-void	*arena_alloc(t_arena *a, size_t size) //equivalent de calloc
-{
-	uintptr_t	curr_ptr; 
-	uintptr_t	offset;
-	void		*ptr;
-
-	curr_ptr = (uintptr_t)a->buf + (uintptr_t)a->curr_offset; //on recupere l adresse de base et on lui ajoute la taille de tout ce qu on a alloue avant qui est stocke dans curr_offset
-	offset = align_forward(curr_ptr, sizeof(void *)); //on passe le curr_ptr que l on vient d initialiser qui est l adresse la plus proche de là ou on a de la place, donc on prend un offset plus loin qui est une puissance de 2
-	offset -= (uintptr_t)a->buf;  //On veut l'offset, soit l adresse - l adresse de base pour juste avoir la taille de la memoire
-	if (offset + size > a->buf_size) //Si l offset + la taille totale que l on veut allouer est superieure a la place dans le buffer, alors on renvoie une erreur
-		return (NULL);
-	ptr = &((unsigned char *)a->buf)[offset]; //on cast pour stocker l adresse qui va etre allouee dans ptr
-	a->prev_offset = offset; //on met a jour l offset dans la structure
-	a->curr_offset = offset + size;
-	arena_memset(ptr, 0, size); //On initialise a 0 l espace memoire renvoyé
-	return (ptr);
-}
-
-//fonction d'allocation custom, initialisation de la pool de mémoire
-void	*arena_init(size_t buffer_size) //initialise la structure d arene, donne la taille totale de la memoire qu on va utiliser dans le programme
-{
-	t_arena	*a;
-	void	*buf;
-
-	buf = malloc(buffer_size);
-	if (!buf)
-		return (NULL);
-	a = malloc(sizeof(t_arena));
-	if (!a)
-		return (NULL);
-	a->buf = buf;
-	a->buf_size = buffer_size;
-	a->curr_offset = 0;
-	a->prev_offset = 0;
-	return (a);
-}
-
-//fonction d'allocation custom, reset de la pool de mémoire
-void	arena_reset(t_arena *a)
-{
-	a->curr_offset = 0;
-	a->prev_offset = 0;
-}
-
-//fonction d'allocation custom, destruction de la pool de mémoire ( free + reset )
-void	arena_destroy(t_arena *a)
-
-{
-	arena_reset(a);
-	if (a->buf)
-		free(a->buf);
-	free(a);
-}
-
-// fonction qui definit la politique d ordonnancement
-void set_thread_policy_and_priority(pthread_t thread, int policy, int priority) {
-    struct sched_param param;
-    param.sched_priority = priority;
-    if (pthread_setschedparam(thread, policy, &param) != 0) {
-        perror("Failed to set thread scheduling policy and priority");
-        exit(EXIT_FAILURE);
-    }
-}
-
-//initialisation du plateau de jeu
-void	init_board(t_arena *arena, t_board *board)
-{
-	int	i;
-	int	j;
-
-	i = 0;
-	board->board = (char **)arena_alloc(arena, sizeof(char *) * board->size);
-	while (i < board->size)
-	{
-		j = 0;
-		while (j < board->size)
-		{
-			if (j == 0)
-				board->board[i] = (char *)arena_alloc(arena, sizeof(char)
-					* board->size);
-			board->board[i][j] = ' ';
-			j++;
-		}
-		i++;
-	}
-}
-
-//affichage du plateau de jeu
-void	print_board(t_board *board)
-{
-	int	i;
-	int	j;
-
-	i = 0;
-	while (i < board->size)
-	{
-		j = 0;
-		while (j < board->size)
-		{
-			putchar(' ');
-			putchar(board->board[i][j]);
-			putchar(' ');
-			if (j < board->size - 1)
-				putchar('|');
-			j++;
-		}
-		putchar('\n');
-		if (i < board->size - 1)
-		{
-			j = 0;
-			while (j < board->size)
-			{
-				printf("---");
-				if (j < board->size - 1)
-					putchar('+');
-				j++;
-			}
-			putchar('\n');
-		}
-		i++;
-	}
-	putchar('\n');
-}
+#include "tictactoe.h"
 
 //choix du mode de jeu
 void	set_game_mode(t_arena *arena, t_game *game)
@@ -300,38 +79,45 @@ void	set_boardsize(t_arena *arena, t_board *board)
 	board->size = size;
 }
 
-//fonction de jeu aleatoire de l'ordinateur
-void	tourOrdinateur(t_board *board, t_game *game)
+//coup choisi par le moteur de l'IA player, -1 si elle joue au hasard
+//seules les IA difficile et MCTS lisent la table de finales et le livre d'ouvertures :
+//les niveaux faciles gardent leurs erreurs, des l'ouverture
+static int	ai_engine_move(t_game *game, t_board *board, int player)
 {
-	FILE		*fp;
-	char		filename[100];
+	int	cell;
 
-	is_game_done(game->arena, board, game);
-	int ligne, colonne;
-	uintptr_t	game_ptr_val = (uintptr_t)game;
-  
-	sprintf(filename, "./history/game_coordinates_%lu.txt", game_ptr_val); //on initialise le nom du fichier
-	fp = fopen(filename, "a"); //entier qui sert d id au fichier
-	if (fp == NULL)
-	{
-		fprintf(stderr, "Failed to open file for writing\n");
-		exit(EXIT_FAILURE);
-	}
-	srand(time(NULL) + game_ptr_val); //on recupere le temps et le pointeur vers la partie pour avoir de l aleatoire reel
-	while (1)
+	if (game->mcts[player] == NULL && game->search[player] == NULL)
+		return (-1);
+	cell = -1;
+	if (game->use_tables[player])
+		cell = tb_move(board, player); //3*3 et 4*4 : jeu parfait lu dans la table
+	if (cell >= 0)
+		game->tb_moves++;
+	else if (game->use_tables[player])
 	{
-		ligne = rand() % board->size; //on genere une coord x aleatoire 
-		colonne = rand() % board->size; //on genere une coord y aleatoire
-		if (board->board[ligne][colonne] == ' ')
-		{
-			board->board[ligne][colonne] = game->player_turn == 0 ? 'X' : 'O'; //on verifie si la case est deja jouee
-  
-			fprintf(fp, "Player %d: (%d, %d)\n", game->player_turn + 1, ligne+1,
-				colonne+1);
-			break ;
-		}
+		cell = book_move(board, player);
+		if (cell >= 0)
+			game->book_moves++;
 	}
-	fclose(fp); //on ferme le fichier
+	if (cell >= 0)
+		return (cell);
+	if (game->mcts[player] != NULL)
+		return (mcts_best_move(game->mcts[player], board, player));
+	if (game->search[player] != NULL)
+		return (search_best_move(game->search[player], board, player));
+	return (-1);
+}
+
+//fonction de jeu de l'ordinateur : moteur de l'IA si elle en a un, sinon coup aleatoire
+void	tourOrdinateur(t_board *board, t_game *game)
+{
+	is_game_done(game->arena, board, game);
+	int				cell;
+
+	cell = ai_engine_move(game, board, game->player_turn);
+	if (cell < 0)
+		cell = board_random_cell(board, &game->rng); //un tirage parmi les cases libres
+	board_play(board, cell, game->player_turn);
 }
 
 //fonction de jeu d'un tour de jeu dependant du mode de jeu et du tour
@@ -341,20 +127,11 @@ void	play_one_turn(t_arena *arena, t_board *board, t_game *game)
 	int			y;
 	char		*input;
 	int			nb;
-	uintptr_t	game_ptr_val;
-	FILE		*fp;
-	char		filename[100];
+	t_arena_mark	mark;
 
-	game_ptr_val = (uintptr_t)game;
-	sprintf(filename, "./history/game_coordinates_%lu.txt", game_ptr_val);
-	fp = fopen(filename, "a");
-	if (fp == NULL)
-	{
-		fprintf(stderr, "Failed to open file for writing\n");
-		exit(EXIT_FAILURE);
-	}
 	x = 0;
 	y = 0;
+	mark = arena_mark(arena); //la saisie du tour est rendue a la fin du tour
 	input = (char *)arena_alloc(arena, sizeof(char) * 2);
 	if (game->game_type == 1)
 	{
@@ -366,7 +143,7 @@ void	play_one_turn(t_arena *arena, t_board *board, t_game *game)
 		nb = scanf("%s", input);
 		y = atoi(input);
 		while (x < 1 || x > board->size || y < 1 || y > board->size
-			|| board->board[x - 1][y - 1] != ' ')
+			|| board_get(board, x - 1, y - 1) != ' ')
 		{
 			printf("Invalid coordinates\n");
 			printf("Enter coordinates (l c):\n");
@@ -377,9 +154,7 @@ void	play_one_turn(t_arena *arena, t_board *board, t_game *game)
 			if (nb)
 				y = atoi(input);
 		}
-		fprintf(fp, "Player %d: (%d, %d)\n", game->player_turn + 1, x, y);
-		board->board[x - 1][y - 1] = game->player_turn == 0 ? 'X' : 'O'; //si le player_turn est pas 0 alors on met O
-		fclose(fp);
+		board_set(board, x - 1, y - 1, game->player_turn == 0 ? 'X' : 'O'); //si le player_turn est pas 0 alors on met O
 		is_game_done(arena, board, game); //verification si la partie est terminee
 	}
 	else if (game->game_type == 2)
@@ -395,7 +170,7 @@ void	play_one_turn(t_arena *arena, t_board *board, t_game *game)
 			if (nb)
 				y = atoi(input);
 			while (x < 1 || x > board->size || y < 1 || y > board->size
-				|| board->board[x - 1][y - 1] != ' ')
+				|| board_get(board, x - 1, y - 1) != ' ')
 			{
 				printf("Invalid coordinates\n");
 				printf("Enter coordinates (l c):\n");
@@ -406,203 +181,418 @@ void	play_one_turn(t_arena *arena, t_board *board, t_game *game)
 				if (nb)
 					y = atoi(input);
 			}
-			fprintf(fp, "Player %d: (%d, %d)\n", game->player_turn + 1, x, y);
-			fclose(fp);
-			board->board[x - 1][y - 1] = 'X';
+			board_set(board, x - 1, y - 1, 'X');
 			is_game_done(arena, board, game);
 		}
 		else
 		{
 			printf("AI's turn\n");
-			fclose(fp);
 			tourOrdinateur(board, game);
 			is_game_done(arena, board, game);
 		}
 	}
 	game->player_turn = game->player_turn == 0 ? 1 : 0; //Quand le tour est fini, on passe au tour suivant
+	arena_release(arena, mark);
 }
 
-//fonction de verification de victoire
-int	verifierGagnantDynamic(char **plateau, char symbole, int boardSize)
+//fonction de verification de fin de partie et d'affichage du gagnant
+//seules les lignes du dernier coup peuvent avoir change : board_play a deja mis a jour winner et empty
+void	is_game_done(t_arena *arena, t_board *board, t_game *game)
 {
-	int	sequenceToWin; //nombre de symboles a aligner pour gagner : 3 en 3*3, 4 sinon
-	int	horizontalSequence;
-	int	diagonalSequence1; //diagonale vers la gauche
-	int	diagonalSequence2; //diagonale vers la droite
-	int	verticalSequence;
+	t_log_seed	seed;
 
-	sequenceToWin = 4;
-	if (boardSize == 3)
-		sequenceToWin = 3;
-	for (int i = 0; i < boardSize; i++)
+	if (board->winner == -1 && board->empty > 0)
+		return ; //la partie continue, rien a ecrire
+	if (game->pool != NULL)
 	{
-		for (int j = 0; j < boardSize; j++)
-		{
-			if (plateau[i][j] == symbole)
-			{
-				horizontalSequence = 0, verticalSequence = 0;
-				diagonalSequence1 = 0, diagonalSequence2 = 0;
-				for (int k = 0; k < sequenceToWin; k++)
-				{
-  
-					if (i + k < boardSize && plateau[i + k][j] == symbole)
-						horizontalSequence++; //on verifie si a droite il y a un symbole, si oui on augmente de 1 la sequence
-					if (j + k < boardSize && plateau[i][j + k] == symbole)
-						verticalSequence++; 
-					if (i + k < boardSize && j + k < boardSize && plateau[i
-						+ k][j + k] == symbole)
-						diagonalSequence1++;
-					if (i + k < boardSize && j - k >= 0 && plateau[i + k][j
-						- k] == symbole)
-						diagonalSequence2++;
-				}
-  
-				if (horizontalSequence == sequenceToWin
-					|| verticalSequence == sequenceToWin
-					|| diagonalSequence1 == sequenceToWin
-					|| diagonalSequence2 == sequenceToWin)
-					return (1);
-			}
-		}
+		seed.seed = game->seed;
+		seed.levels[0] = game->pool->levels[0];
+		seed.levels[1] = game->pool->levels[1];
+	}
+	if (board->winner != -1)
+	{
+		if (game->game_type != 3)
+			printf("Player %d wins!\n", game->player_turn + 1);
+	}
+	else if (game->game_type != 3)
+		printf("It's a tie!\n");
+	PROF_BEGIN(t_log);
+	if (game->ring)
+		logring_push(game->ring, board, game->first_player,
+			board->winner == -1 ? LOG_RESULT_TIE : board->winner,
+			game->pool->seed_only ? &seed : NULL); //le thread ecrivain fera l'entree/sortie
+	else if (game->log)
+		gamelog_append(game->log, board, game->first_player,
+			board->winner == -1 ? LOG_RESULT_TIE : board->winner); //une seule ecriture par partie
+	PROF_END(PROF_LOG_PUSH, t_log);
+	if (game->game_type != 3)
+	{
+		print_board(board);
+		if (game->log)
+			gamelog_close(game->log);
+		arena_destroy(arena);
+		exit(0);
+	}
+	game->player_turn = -1;
+}
+
+//fonction d'initialisation de la structure de jeu
+void	init_game(t_arena *arena, t_game *game)
+{
+	game->board = (t_board *)arena_alloc(arena, sizeof(t_board));
+	game->player_turn = 0;
+	if (game->game_type > 0 && game->game_type < 3)
+		game->player_turn = game->game_type;
+	else
+		game->game_type = 0;
+	game->mutex = (pthread_mutex_t *)arena_alloc(arena,
+		sizeof(pthread_mutex_t));
+	pthread_mutex_init(game->mutex, NULL);
+	game->sem = (sem_t *)arena_alloc(arena, 2 * sizeof(sem_t)); //On alloue la memoire pour les semaphores
+	sem_init(game->sem, 0, 0); //les deux semaphores sont a 0 : pool_next_game poste celui du thread qui commence la partie
+	sem_init(game->sem + 1, 0, 0);
+}
+
+//chaque partie repart de sa graine : coups aleatoires et melange des moteurs
+static void	ai_reseed(t_game *game)
+{
+	rng_seed(&game->rng, game->seed);
+	for (int p = 0; p < 2; p++)
+	{
+		if (game->search[p] != NULL)
+			rng_seed(&game->search[p]->rng, game->seed + 1 + (uint64_t)p);
+		for (int i = 0; game->mcts[p] != NULL && i < game->mcts[p]->nb_threads; i++)
+			rng_seed(&game->mcts[p]->threads[i].rng, game->seed + 3 + (uint64_t)(p + 2 * i));
 	}
-	return (0);
 }
 
-//fonction de verification de match nul
-int	verifierMatchNul(char **plateau, int boardSize)
+//donne au worker la prochaine partie de la file partagee, renvoie 0 quand la file est vide
+//le numero de partie est pris sans verrou (atomic_fetch_add) : n'importe quel thread peut l'appeler,
+//pourvu qu'aucune IA du worker ne joue a ce moment (debut du lot, ou fin de la partie precedente)
+static int	pool_next_game(t_game *game)
 {
-	int	i;
-	int	j;
+	int		index;
 
-	i = 0;
-	while (i < boardSize)
+	index = atomic_fetch_add(&game->pool->next_game, 1);
+	if (index >= game->pool->nb_games)
 	{
-		j = 0;
-		while (j < boardSize)
+		game->done = 1; //plus de partie : on reveille les deux threads pour qu'ils se terminent
+		if (game->exec_mode == EXEC_TWO_THREADS)
 		{
-			if (plateau[i][j] == ' ')
-				return (0);
-			j++;
+			sem_post(game->sem);
+			sem_post(game->sem + 1);
 		}
-		i++;
+		return (0);
 	}
+	TRACE_INSTANT(TRACE_GAME_START, (uint32_t)index);
+	game->id = game->pool->base_id + (uintptr_t)index;
+	game->seed = rng_derive(game->pool->seed, (uint64_t)index); //ne depend que du numero de la partie
+	ai_reseed(game);
+	init_board(game->board);
+	game->first_player = (int)(game->seed & 1); //camp qui commence tire de la graine de la partie
+	game->player_turn = game->first_player;
+	if (game->latency != NULL)
+		game->started = prof_now();
+	if (game->exec_mode == EXEC_TWO_THREADS)
+		sem_post(game->sem + game->first_player); //on reveille le thread de l'IA qui commence
 	return (1);
-} //verifie si il y a des cases de libres sur le plateau
+}
 
-//fonction de verification de fin de partie et d'affichage du gagnant
-void	is_game_done(t_arena *arena, t_board *board, t_game *game)
+//fin d'une partie : on compte le resultat dans le worker et on enchaine sur la suivante
+static void	pool_game_over(t_game *game)
+{
+	if (game->board->winner == 0)
+		game->results[0]++;
+	else if (game->board->winner == 1)
+		game->results[1]++;
+	else
+		game->results[2]++;
+	if (game->latency != NULL)
+		prof_hist_add(game->latency, prof_now() - game->started);
+	pool_next_game(game);
+}
+
+//temps ecoule (horloge murale) en secondes
+static double	wall_time(void)
 {
-	char		symbole;
-	uintptr_t	game_ptr_val;
-	FILE		*fp;
-	char		filename[100];
+	struct timespec	ts;
 
-	game_ptr_val = (uintptr_t)game;
-	sprintf(filename, "./history/game_coordinates_%lu.txt", game_ptr_val);
-	fp = fopen(filename, "a");
-	if (fp == NULL)
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((double)ts.tv_sec + (double)ts.tv_nsec / 1e9);
+}
+
+//demande le niveau d'une IA, et le budget par coup de la recherche Monte Carlo
+static void	ask_ai(t_ai_config *ai, const char *name)
+{
+	memset(ai, 0, sizeof(*ai));
+	printf("%s level? (0 = random, 1 = easy, 2 = medium, 3 = hard, 4 = MCTS): ",
+		name);
+	if (scanf("%d", &ai->level) != 1 || ai->level < AI_LEVEL_RANDOM
+		|| ai->level > AI_LEVEL_MCTS)
+		ai->level = AI_LEVEL_RANDOM;
+	if (ai->level != AI_LEVEL_MCTS)
 	{
-		fprintf(stderr, "Failed to open file for writing\n");
-		exit(EXIT_FAILURE);
+		if (ai->level == AI_LEVEL_RANDOM)
+			return ;
+		printf("Transposition table size in MB? (0 for %d): ", TT_DEFAULT_MB);
+		if (scanf("%ld", &ai->tt_mb) != 1 || ai->tt_mb < 0)
+			ai->tt_mb = 0;
+		return ;
 	}
-	symbole = game->player_turn == 0 ? 'X' : 'O';
-	if (game->player1 == 1)
-		symbole = symbole == 'X' ? 'O' : 'X';
-	if (verifierGagnantDynamic(board->board, symbole, board->size))
+	printf("MCTS threads? (0 for one per CPU, one per worker in AI vs AI): ");
+	if (scanf("%d", &ai->nb_threads) != 1 || ai->nb_threads < 0)
+		ai->nb_threads = 0;
+	printf("Playouts per move? (0 for a time budget): ");
+	if (scanf("%ld", &ai->playouts) != 1 || ai->playouts < 0)
+		ai->playouts = 0;
+	if (ai->playouts == 0)
 	{
-		if (game->game_type != 3)
-			printf("Player %d wins!\n", game->player_turn + 1);
-		fprintf(fp, "Player %d wins\n", game->player_turn + 1);
-		fclose(fp);
-		if (game->game_type != 3)
-		{
-			print_board(board);
-			arena_destroy(arena);
-			exit(0);
-		}
-		game->player_turn = -1;
-		return ;
+		printf("Milliseconds per move? ");
+		if (scanf("%ld", &ai->time_ms) != 1 || ai->time_ms < 1)
+			ai->time_ms = 1000;
 	}
-	symbole = game->player_turn == 1 ? 'O' : 'X';
-	if (game->player1 == 1)
-		symbole = symbole == 'X' ? 'O' : 'X';
-	if (verifierGagnantDynamic(board->board, symbole, board->size))
+}
+
+//table de transposition partagee par les IA a recherche de ais, NULL si aucune n'en a besoin
+static t_tt	*ai_create_tt(t_arena *arena, const t_ai_config *ais, int nb_ais)
+{
+	t_tt	*tt;
+	long	mb;
+
+	mb = -1;
+	for (int i = 0; i < nb_ais; i++)
+		if (ais[i].level != AI_LEVEL_RANDOM && ais[i].level != AI_LEVEL_MCTS
+			&& ais[i].tt_mb > mb)
+			mb = ais[i].tt_mb;
+	if (mb < 0)
+		return (NULL);
+	tt = (t_tt *)arena_alloc(arena, sizeof(t_tt));
+	tt_init(arena, tt, mb);
+	return (tt);
+}
+
+//cree le moteur de l'IA player d'une partie selon ses reglages
+static void	ai_create(t_arena *arena, t_game *game, int player,
+	const t_ai_config *ai, t_tt *tt)
+{
+	t_ai_config	cfg;
+
+	game->use_tables[player] = ai->level >= AI_LEVEL_HARD; //difficile et MCTS : table et livre
+	if (ai->level == AI_LEVEL_MCTS)
 	{
-		if (game->game_type != 3)
-			printf("Player %d wins!\n", game->player_turn + 1);
-		fprintf(fp, "Player %d wins\n", game->player_turn + 1);
-		if (game->game_type != 3)
+		cfg = *ai;
+		if (game->pool != NULL && cfg.nb_threads <= 0)
+			cfg.nb_threads = 1; //dans un lot, les autres workers occupent deja les processeurs
+		game->mcts[player] = (t_mcts *)arena_alloc(arena, sizeof(t_mcts));
+		mcts_init(arena, game->mcts[player], &cfg, rng_next(&game->rng));
+	}
+	else if (ai->level != AI_LEVEL_RANDOM)
+	{
+		game->search[player] = (t_search *)arena_alloc(arena, sizeof(t_search));
+		search_init(game->search[player], ai->level, tt, rng_next(&game->rng));
+	}
+}
+
+//temps processeur de tout le processus (tous les threads) en secondes
+static double	cpu_time(void)
+{
+	struct timespec	ts;
+
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	return ((double)ts.tv_sec + (double)ts.tv_nsec / 1e9);
+}
+
+//joue un lot de parties IA contre IA sur b->nb_workers workers dans le mode d'execution donne
+//b->ais donne les reglages de chaque IA : chaque worker a ses propres moteurs
+//remplit r : resultats, coups, temps mural et processeur, compteurs de la table et du journal
+void	run_ai_batch(t_arena *arena, const t_batch *b, t_batch_result *r)
+{
+	static uintptr_t	ids_used = 0; //nombre d'identifiants deja donnes par les lots precedents
+	t_pool		*pool;
+	t_game		*workers;
+	t_logring	*ring;
+	t_tt		*tt;
+	double		start;
+	double		cpu;
+	int			i;
+	t_arena_mark	mark;
+	t_prof_hist	*latency;
+#ifdef TTT_PROFILE
+	t_prof		*prof;
+#endif
+#ifdef TTT_TRACE
+	char		name[32];
+#endif
+
+	mark = arena_mark(arena); //tout le lot est rendu a la fin : un lot de plus ne coute rien
+	memset(r, 0, sizeof(*r));
+	pool = (t_pool *)arena_alloc(arena, sizeof(t_pool));
+	pool->nb_games = b->nb_games;
+	atomic_init(&pool->next_game, 0);
+	pool->base_id = ((uintptr_t)getpid() << 32) + ids_used; //identifiants uniques entre les lots et entre les processus
+	ids_used += (uintptr_t)b->nb_games;
+	pool->seed = b->seed;
+	pool->seed_only = b->seed_only;
+	pool->levels[0] = (unsigned char)b->ais[0].level;
+	pool->levels[1] = (unsigned char)b->ais[1].level;
+	atomic_init(&pool->sched_errors, 0);
+	workers = (t_game *)arena_alloc(arena, sizeof(t_game) * b->nb_workers); //les workers sont alloues une seule fois pour tout le lot
+	ring = NULL;
+#ifdef TTT_TRACE
+	trace_begin();
+#endif
+	if (b->io)
+	{
+		ring = (t_logring *)arena_alloc(arena, sizeof(t_logring));
+#ifdef TTT_TRACE
+		trace_init(arena, &ring->trace, "log writer");
+#endif
+		logring_start(arena, ring, b->block); //un seul thread ecrit les parties de tous les workers
+	}
+	tt = ai_create_tt(arena, b->ais, 2); //une seule table pour toutes les recherches du lot
+	i = -1;
+	while (++i < b->nb_workers)
+	{
+		workers[i].arena = arena_init(ARENA_CHUNK_SIZE); //arene propre au worker : plateau, moteurs
+		if (workers[i].arena == NULL)
 		{
-			print_board(board);
-			arena_destroy(arena);
-			fclose(fp);
-			exit(0);
+			fprintf(stderr, "Not enough memory for worker %d\n", i);
+			exit(EXIT_FAILURE);
 		}
-		game->player_turn = -1;
-		return ;
+		init_game(workers[i].arena, workers + i);
+		workers[i].board->size = b->size;
+		workers[i].game_type = 3;
+		workers[i].pool = pool;
+		workers[i].done = 0;
+		workers[i].policy = b->policy;
+		workers[i].priority = b->priority;
+		for (int p = 0; p < 2; p++) //processeurs choisis ici, avant le lancement des threads
+			workers[i].cpu[p] = sched_place_cpu(b->placement, i, p,
+					b->exec_mode == EXEC_TWO_THREADS ? 2 : 1);
+		workers[i].latency = NULL;
+		if (b->latency)
+			workers[i].latency = (t_prof_hist *)arena_alloc(workers[i].arena,
+					sizeof(t_prof_hist));
+		workers[i].exec_mode = b->exec_mode;
+		workers[i].ring = ring; //NULL sans entrees/sorties : les parties ne sont pas ecrites
+		rng_seed(&workers[i].rng, rng_derive(b->seed, (uint64_t)i)); //graines des moteurs, refaites a chaque partie
+		ai_create(workers[i].arena, workers + i, 0, b->ais, tt);
+		ai_create(workers[i].arena, workers + i, 1, b->ais + 1, tt);
+#ifdef TTT_TRACE
+		for (int p = 0; p < (b->exec_mode == EXEC_TWO_THREADS ? 2 : 1); p++)
+		{
+			if (b->exec_mode == EXEC_TWO_THREADS)
+				snprintf(name, sizeof(name), "worker %d AI %d", i, p + 1);
+			else
+				snprintf(name, sizeof(name), "worker %d", i);
+			trace_init(arena, workers[i].trace + p, name); //journal alloue avant le lancement des threads
+		}
+#endif
 	}
-	if (verifierMatchNul(board->board, board->size))
+	start = wall_time();
+	cpu = cpu_time();
+	i = -1;
+	while (++i < b->nb_workers)
 	{
-		if (game->game_type != 3)
-			printf("It's a tie!\n");
-		fprintf(fp, "Tie\n");
-		if (game->game_type != 3)
+		if (b->exec_mode == EXEC_SINGLE_THREAD)
+			pthread_create(workers[i].thread, NULL, thread_IA_single, (void *)(workers + i));
+		else
 		{
-			print_board(board);
-			fclose(fp);
-			arena_destroy(arena);
-			exit(0);
+			pthread_create(workers[i].thread, NULL, thread_IA1, (void *)(workers + i));
+			pthread_create(workers[i].thread + 1, NULL, thread_IA2, (void *)(workers + i));
+			pool_next_game(workers + i); //lance la premiere partie du worker
 		}
-		game->player_turn = -1;
-		return ;
 	}
-	fclose(fp);
+	latency = (t_prof_hist *)arena_alloc(arena, sizeof(t_prof_hist));
+#ifdef TTT_PROFILE
+	prof = (t_prof *)arena_alloc(arena, sizeof(t_prof));
+#endif
+	i = -1;
+	while (++i < b->nb_workers)
+	{
+		pthread_join(workers[i].thread[0], NULL); //permet d attendre que les threads du worker soient terminés
+		if (b->exec_mode == EXEC_TWO_THREADS)
+			pthread_join(workers[i].thread[1], NULL);
+		sem_destroy(workers[i].sem); //on detruit les semaphores
+		sem_destroy(workers[i].sem + 1);
+		pthread_mutex_destroy(workers[i].mutex); //on detruit le mutex
+		r->results[0] += workers[i].results[0]; //on fusionne les resultats des workers
+		r->results[1] += workers[i].results[1];
+		r->results[2] += workers[i].results[2];
+		r->moves += workers[i].moves;
+		r->tb_moves += workers[i].tb_moves;
+		r->book_moves += workers[i].book_moves;
+		if (workers[i].latency != NULL)
+			prof_hist_merge(latency, workers[i].latency);
+#ifdef TTT_PROFILE
+		prof_merge(prof, workers[i].prof);
+		prof_merge(prof, workers[i].prof + 1);
+#endif
+		for (int p = 0; p < 2; p++)
+			if (workers[i].mcts[p] != NULL)
+				mcts_free(workers[i].mcts[p]); //les threads de recherche vivent le temps du lot
+		arena_destroy(workers[i].arena);
+	}
+	if (ring != NULL)
+	{
+		logring_stop(ring); //ecrit les dernieres parties et ferme le journal
+		r->dropped = atomic_load(&ring->dropped);
+#ifdef TTT_PROFILE
+		prof_merge(prof, &ring->prof);
+#endif
+	}
+	r->wall = wall_time() - start;
+	r->cpu = cpu_time() - cpu;
+	r->sched_errors = atomic_load(&pool->sched_errors);
+	if (b->latency)
+	{
+		r->has_latency = 1;
+		r->latency_p50 = prof_percentile(latency, 500);
+		r->latency_p99 = prof_percentile(latency, 990);
+	}
+#ifdef TTT_PROFILE
+	prof_report(prof); //sur stderr : la sortie JSON du bench reste lisible
+#endif
+#ifdef TTT_TRACE
+	trace_write(); //tous les threads du lot sont termines
+#endif
+	if (tt != NULL)
+	{
+		r->has_tt = 1;
+		r->tt_hits = atomic_load(&tt->hits);
+		r->tt_misses = atomic_load(&tt->misses);
+		r->tt_collisions = atomic_load(&tt->collisions);
+	}
+	arena_release(arena, mark);
 }
 
-//fonction d'initialisation de la structure de jeu
-void	init_game(t_arena *arena, t_game *game)
+//compteurs d'un lot qui ne s'affichent que s'ils servent
+static void	print_batch_counters(const t_batch_result *r)
 {
-	game->board = (t_board *)arena_alloc(arena, sizeof(t_board));
-	game->player_turn = 0;
-	if (game->game_type > 0 && game->game_type < 3)
-		game->player_turn = game->game_type;
-	else
-		game->game_type = 0;
-	game->mutex = (pthread_mutex_t *)arena_alloc(arena,
-		sizeof(pthread_mutex_t));
-	pthread_mutex_init(game->mutex, NULL);
-	game->sem = (sem_t *)arena_alloc(arena, 2 * sizeof(sem_t)); //On alloue la memoire pour les semaphores
-	sem_init(game->sem, 0, 1); //on initialise avec 1 ou 0 les semaphores pour definir quel thread va fonctionner ou non 
-	sem_init(game->sem + 1, 0, 0); //l'autre ne fonctionne pas
-}
-
-void adjust_file_ownership(const char* filename) { //fixbug lors du changement de politique il faut les droits admin, car quand on ouvre des fichiers, il y en a en haute priorite
-    struct passwd *pw = getpwuid(getuid());
-    if (pw == NULL) {
-        perror("getpwuid");
-        exit(EXIT_FAILURE);
-    }
-    uid_t user_id = pw->pw_uid;
-    gid_t group_id = pw->pw_gid;
-
-    if (chown(filename, user_id, group_id) < 0) {
-        perror("chown");
-        exit(EXIT_FAILURE);
-    }
+	if (r->dropped > 0)
+		printf("Log records dropped (queue full): %lu\n", r->dropped);
+	if (r->sched_errors > 0)
+		printf("Scheduling settings refused for %d threads (real-time policies need "
+			"CAP_SYS_NICE), they ran with the system defaults\n", r->sched_errors);
+	if (r->has_tt)
+		printf("Transposition table: %ld hits, %ld misses, %ld collisions\n",
+			r->tt_hits, r->tt_misses, r->tt_collisions);
 }
 
-//fonction de jeu de l'ordinateur contre l'ordinateur ( 2 threads )
+//fonction de jeu de l'ordinateur contre l'ordinateur ( pool de workers )
 void	iavsiathread(t_arena *arena, int size)
 {
-	char	*input;
-	int		nb;
-	int		nbGames;
-	int		i;
-	t_board	*iaboard;
-	t_game	*iagame;
+	char			*input;
+	int				nb;
+	int				nbGames;
+	t_batch			b;
+	t_batch_result	r;
+	double			start;
+	double			cpu;
 
-	clock_t start, end;
-	uintptr_t	game_ptr_val;
+	memset(&b, 0, sizeof(b));
+	b.size = size;
+	b.io = 1;
 	printf(" AI vs AI\n");
 	printf(" How many games do you want to play? :\n");
 	input = (char *)arena_alloc(arena, sizeof(char) * 2);
@@ -616,55 +606,90 @@ void	iavsiathread(t_arena *arena, int size)
 		if (nb)
 			nbGames = atoi(input);
 	}
-	i = 0;
+	b.nb_games = nbGames;
 	//ask the player if he want the policy changed
-	printf("Do you want to change the scheduling policy? (y/n): ");
+	printf("Do you want to change the scheduling policy or thread placement? (y/n): ");
 	input = (char *)arena_alloc(arena, sizeof(char) * 2);
 	scanf("%s", input);
+	b.policy = -1;
 	if (input[0] == 'y')
 	{
-		printf("Enter the scheduling policy (0 for FIFO, 1 for RR): ");
+		printf("Enter the scheduling policy (0 for FIFO, 1 for RR, 2 for the system default): ");
 		scanf("%s", input);
-	}
-	start = clock(); //on lance le chrono
-	while (i < nbGames)
-	{
-		iagame = (t_game *)arena_alloc(arena, sizeof(t_game));
-		init_game(arena, iagame);
-		iaboard = iagame->board;
-		iaboard->size = size;
-		game_ptr_val = (uintptr_t)iagame;
-		srand(time(NULL) + game_ptr_val);
-		iagame->player_turn = rand() % 2; //determine quelle IA va jouer en premier
-		iagame->game_type = 3;
-		iagame->board = iaboard;
-		iagame->arena = arena;
-		iagame->done = 0;
-		iagame->policy = -1;
 		if (input[0] == '0')
-			iagame->policy = SCHED_FIFO;
+			b.policy = SCHED_FIFO;
 		else if (input[0] == '1')
-			iagame->policy = SCHED_RR;
-		init_board(arena, iaboard);
-		if (iagame->player_turn) 
-		{
-			pthread_create(iagame->thread, NULL, thread_IA1, (void *)iagame);
-			pthread_create(iagame->thread + 1, NULL, thread_IA2, (void *)iagame);
-		}
-		else
+			b.policy = SCHED_RR;
+		if (b.policy != -1)
 		{
-			pthread_create(iagame->thread, NULL, thread_IA2, (void *)iagame);
-			pthread_create(iagame->thread + 1, NULL, thread_IA1, (void *)iagame);
+			printf("Priority? (%d-%d, 0 for the highest): ", sched_get_priority_min(b.policy),
+				sched_get_priority_max(b.policy));
+			if (scanf("%d", &b.priority) != 1 || b.priority < 0
+				|| b.priority > sched_get_priority_max(b.policy))
+				b.priority = 0;
 		}
-		pthread_join(iagame->thread[0], NULL); //permet d attendre que le thread 0 soit terminé
-		pthread_join(iagame->thread[1], NULL);
-		sem_destroy(iagame->sem); //on detruit les semaphores
-		sem_destroy(iagame->sem + 1);
-		pthread_mutex_destroy(iagame->mutex); //on detruit le mutex
-		i++;
+		printf("Thread placement? (0 = system, 1 = same core, 2 = sibling hyperthreads, "
+			"3 = separate cores): ");
+		if (scanf("%d", &b.placement) != 1 || b.placement < PLACE_OS
+			|| b.placement > PLACE_SEPARATE)
+			b.placement = PLACE_OS;
+	}
+	printf("How many worker threads? (0 for one per CPU): ");
+	b.nb_workers = 0;
+	if (scanf("%d", &b.nb_workers) != 1 || b.nb_workers < 1)
+		b.nb_workers = default_nb_workers();
+	if (b.nb_workers > nbGames)
+		b.nb_workers = nbGames;
+	printf("Execution mode? (1 = two threads per game, 2 = single thread, 3 = compare both): ");
+	b.exec_mode = 0;
+	if (scanf("%d", &b.exec_mode) != 1 || b.exec_mode < 1 || b.exec_mode > 3)
+		b.exec_mode = 1;
+	printf("When the log queue is full? (b = wait, d = drop and count): ");
+	scanf("%s", input);
+	b.block = input[0] != 'd';
+	ask_ai(b.ais, "AI 1");
+	ask_ai(b.ais + 1, "AI 2");
+	printf("Master seed? (0 for a random one): ");
+	b.seed = 0;
+	if (scanf("%lu", &b.seed) != 1 || b.seed == 0)
+		b.seed = ((uint64_t)time(NULL) << 20) ^ (uint64_t)getpid();
+	printf("Master seed: %lu\n", b.seed); //relancer avec cette graine rejoue les memes parties
+	if (b.ais[0].level == AI_LEVEL_RANDOM && b.ais[1].level == AI_LEVEL_RANDOM)
+	{
+		printf("Store only the seed of each game? (y/n): ");
+		input[0] = 'n';
+		scanf("%s", input);
+		b.seed_only = input[0] == 'y';
+	}
+	start = wall_time(); //on lance le chrono : temps mural, clock() additionnerait les threads
+	cpu = cpu_time();
+	if (b.exec_mode == 3)
+	{
+		//meme lot dans les deux modes pour mesurer le cout des passages de main entre threads
+		b.exec_mode = EXEC_TWO_THREADS;
+		run_ai_batch(arena, &b, &r);
+		print_batch_counters(&r);
+		printf("Two threads:   %ld moves in %f s, %.0f moves/sec\n", r.moves,
+			r.wall, (double)r.moves / r.wall);
+		b.exec_mode = EXEC_SINGLE_THREAD;
+		run_ai_batch(arena, &b, &r);
+		print_batch_counters(&r);
+		printf("Single thread: %ld moves in %f s, %.0f moves/sec\n", r.moves,
+			r.wall, (double)r.moves / r.wall);
+		nbGames *= 2; //les deux lots de la comparaison sont dans l'historique
+	}
+	else
+	{
+		b.exec_mode = b.exec_mode == 2 ? EXEC_SINGLE_THREAD : EXEC_TWO_THREADS;
+		run_ai_batch(arena, &b, &r);
+		print_batch_counters(&r);
+		printf("Time taken: %f\n", wall_time() - start);
+		printf("CPU time: %f\n", cpu_time() - cpu);
+		printf("Workers: %d\n", b.nb_workers);
+		printf("AI 1 wins: %d, AI 2 wins: %d, ties: %d\n", r.results[0], r.results[1],
+			r.results[2]);
+		printf("Moves: %ld, %.0f moves/sec\n", r.moves, (double)r.moves / r.wall);
 	}
-	end = clock(); //on arrete le chrono
-	printf("Time taken: %f\n", ((double)(end - start)) / CLOCKS_PER_SEC);
 	FILE *analysis_fp = fopen("./history/analyse.txt", "a");
 	adjust_file_ownership("./history/analyse.txt");
     if (analysis_fp == NULL)
@@ -673,77 +698,89 @@ void	iavsiathread(t_arena *arena, int size)
         exit(EXIT_FAILURE);
     }
 	fprintf(analysis_fp, "Number of games played: %d\n", nbGames);
-	fprintf(analysis_fp, "Time taken: %f\n", ((double)(end - start)) / CLOCKS_PER_SEC);
+	fprintf(analysis_fp, "Time taken: %f\n", wall_time() - start);
 	fclose(analysis_fp);
 }
 
-//fonction de jeu de l'ordinateur contre l'ordinateur thread 1
-void	*thread_IA1(void *arg)
+//applique au thread courant le placement et la politique d'ordonnancement du worker
+//un reglage refuse (pas de droits pour le temps reel, processeur interdit) est compte, et le thread
+//continue avec les reglages du systeme
+static void	ia_apply_policy(t_game *game, int player)
+{
+	int	priority;
+
+	if (game->cpu[player] >= 0 && set_thread_affinity(pthread_self(), game->cpu[player]) != 0)
+		atomic_fetch_add(&game->pool->sched_errors, 1);
+	if (game->policy == -1)
+		return ;
+	priority = game->priority;
+	if (priority == 0)
+		priority = sched_get_priority_max(game->policy);
+	if (set_thread_policy_and_priority(pthread_self(), game->policy, priority) != 0) //on donne le thread, la politique, et le degré de priorité dans la politique
+		atomic_fetch_add(&game->pool->sched_errors, 1);
+}
+
+//coup d'une IA (moteur ou aleatoire), partage par les deux modes d'execution
+//player vaut 0 pour l'IA 1 (X) et 1 pour l'IA 2 (O), renvoie 1 si la partie est terminee
+static int	ia_play_move(t_game *game, int player)
 {
-	t_game		*game;
 	t_board		*board;
-	t_arena		*arena;
-	FILE		*fp;
-	char		filename[100];
-	uintptr_t	game_ptr_val;
+	int			cell;
 
-	game = (t_game *)arg;
-	board = game->board;
-	arena = game->arena;
-	int ligne, colonne;
-	game = (t_game *)arg;
 	board = game->board;
-	arena = game->arena;
-	game_ptr_val = (uintptr_t)game;
-	if (game->policy != -1)
-	{
-		if (game->policy == 1)
-			set_thread_policy_and_priority(pthread_self(), SCHED_POLICY, sched_get_priority_max(SCHED_POLICY) - 1); //on donne le thread, la politique, et le degré de priorité dans la politique, on change la politique du thread
-		else if (game->policy == 0)
-			set_thread_policy_and_priority(pthread_self(), SCHED_POLICY, sched_get_priority_max(SCHED_POLICY));
-	}
-	sprintf(filename, "./history/game_coordinates_%lu.txt", game_ptr_val);
-	srand(time(NULL) + game_ptr_val);
-	fp = fopen(filename, "a");
-	if (fp == NULL)
-	{
-		fprintf(stderr, "1Failed to open file for writing\n");
-		exit(EXIT_FAILURE);
-	}
-	fprintf(fp, "size:%d\n", game->board->size);
-	fclose(fp);
-	while (game->done != 1)
+	PROF_BEGIN(t_move);
+	cell = ai_engine_move(game, board, player);
+	if (cell < 0)
+		cell = board_random_cell(board, &game->rng);
+	board_play(board, cell, player);
+	PROF_END(PROF_MOVE, t_move);
+	game->moves++;
+	PROF_BEGIN(t_done);
+	is_game_done(game->arena, board, game);
+	PROF_END(PROF_GAME_DONE, t_done);
+	if (game->player_turn == -1) //si c'est terminé, is_game_done met le player_turn a -1
+		return (1);
+	game->player_turn = player == 0 ? 1 : 0;
+	return (0);
+}
+
+//boucle d'un thread d'IA en mode deux threads : on attend notre semaphore, on joue, on passe la main
+static void	ia_thread_loop(t_game *game, int player)
+{
+	ia_apply_policy(game, player);
+#ifdef TTT_PROFILE
+	prof_attach(game->prof + player);
+#endif
+#ifdef TTT_TRACE
+	trace_attach(game->trace + player);
+#endif
+	while (1)
 	{
-		sem_wait(game->sem);//tant que notre sem est egal a 0, on attend
+		PROF_BEGIN(t_sem);
+		sem_wait(game->sem + player);//tant que notre sem est egal a 0, on attend
+		PROF_END(PROF_SEM_WAIT, t_sem);
 		if (game->done == 1)
 			break ;
+		PROF_BEGIN(t_mutex);
 		pthread_mutex_lock(game->mutex);//lock le mutex, si il est deja lock, on attend
-		while (1)
+		PROF_END(PROF_MUTEX_WAIT, t_mutex);
+		if (ia_play_move(game, player))
 		{
-			ligne = rand() % board->size;
-			colonne = rand() % board->size;
-			if (board->board[ligne][colonne] == ' ')
-			{
-				board->board[ligne][colonne] = 'X';
-				adjust_file_ownership(filename);
-				fp = fopen(filename, "a");
-				if (fp == NULL)
-				{
-					fprintf(stderr, "Failed to open file for writing\n");
-					exit(EXIT_FAILURE);
-				}
-				fprintf(fp, "Player 1: (%d, %d)\n", ligne+1, colonne+1);
-				fclose(fp);
-				break ;
-			}
+			pool_game_over(game); //la partie suivante est lancee par le thread qui a fini celle-ci
+			pthread_mutex_unlock(game->mutex);
+			continue ;
 		}
-		is_game_done(arena, board, game);
-		if (game->player_turn == -1) //si c'est terminé, on a une fonction qui met le player_turn a -1, donc on met le game_done
-			game->done = 1;
-		game->player_turn = 1;
 		pthread_mutex_unlock(game->mutex);//on delock le mutex
-		sem_post(game->sem + 1); //active l'autre semaphore
+		TRACE_INSTANT(TRACE_SEM_POST, 0);
+		sem_post(game->sem + (player == 0 ? 1 : 0)); //active l'autre semaphore
 	}
+}
+
+//fonction de jeu de l'ordinateur contre l'ordinateur thread 1
+//le thread reste vivant pour toutes les parties de son worker
+void	*thread_IA1(void *arg)
+{
+	ia_thread_loop((t_game *)arg, 0);
 	pthread_exit(NULL);//termine le thread
 	return (NULL);//Pour terminer le void*
 }
@@ -751,69 +788,104 @@ void	*thread_IA1(void *arg)
 //fonction de jeu de l'ordinateur contre l'ordinateur thread 2
 void	*thread_IA2(void *arg)
 {
-	t_game		*game;
-	t_board		*board;
-	t_arena		*arena;
-	uintptr_t	game_ptr_val;
-	FILE		*fp;
-	char		filename[100];
+	ia_thread_loop((t_game *)arg, 1);
+	pthread_exit(NULL);
+	return (NULL);
+}
 
+//les deux IA jouent a tour de role dans le meme thread, sans semaphore ni mutex
+void	*thread_IA_single(void *arg)
+{
+	t_game	*game;
 
-	int ligne, colonne;
 	game = (t_game *)arg;
-	board = game->board;
-	arena = game->arena;
-	game_ptr_val = (uintptr_t)game;
-	if (game->policy != -1)
-	{
-		//int policy = game->policy;
-		//int priority = sched_get_priority_max(game->policy);
-		if (game->policy == 1)
-			set_thread_policy_and_priority(pthread_self(), SCHED_POLICY, sched_get_priority_max(SCHED_POLICY) - 1);
-		else if (game->policy == 0)
-			set_thread_policy_and_priority(pthread_self(), SCHED_POLICY, sched_get_priority_max(SCHED_POLICY));
-		//set_thread_policy_and_priority(pthread_self(), SCHED_POLICY, sched_get_priority_max(SCHED_POLICY));
-		//printf("Setting scheduling policy to %d with priority %d\n", policy, priority);
-		//printf("setting thread policy and priority of thread 2 to %d\n", sched_get_priority_max(SCHED_POLICY));
-	}
-	sprintf(filename, "./history/game_coordinates_%lu.txt", game_ptr_val);
-	srand(time(NULL) + game_ptr_val);
+	ia_apply_policy(game, 0);
+#ifdef TTT_PROFILE
+	prof_attach(game->prof);
+#endif
+#ifdef TTT_TRACE
+	trace_attach(game->trace);
+#endif
+	pool_next_game(game);
 	while (game->done != 1)
 	{
-		sem_wait(game->sem + 1);
-		if (game->done == 1)
-			break ;
-		pthread_mutex_lock(game->mutex);
-		while (1)
-		{
-			ligne = rand() % board->size;
-			colonne = rand() % board->size;
-			if (board->board[ligne][colonne] == ' ')
-			{
-				board->board[ligne][colonne] = 'O';
-				adjust_file_ownership(filename);
-				fp = fopen(filename, "a");
-				if (fp == NULL)
-				{
-					fprintf(stderr, "2Failed to open file for writing\n");
-					exit(EXIT_FAILURE);
-				}
-				fprintf(fp, "Player 2: (%d, %d)\n", ligne+1, colonne+1);
-				fclose(fp);
-				break ;
-			}
-		}
-		is_game_done(arena, board, game);
-		if (game->player_turn == -1)
-			game->done = 1;
-		game->player_turn = 0;
-		pthread_mutex_unlock(game->mutex);
-		sem_post(game->sem);
+		if (ia_play_move(game, game->player_turn))
+			pool_game_over(game);
 	}
 	pthread_exit(NULL);
 	return (NULL);
 }
 
+//charge un fichier entier en memoire, renvoie NULL si il ne peut pas etre lu
+static unsigned char	*load_file(const char *filename, size_t *len)
+{
+	FILE			*fp;
+	unsigned char	*buf;
+	long			size;
+
+	fp = fopen(filename, "rb");
+	if (fp == NULL)
+		return (NULL);
+	fseek(fp, 0, SEEK_END);
+	size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	buf = NULL;
+	if (size > 0)
+		buf = (unsigned char *)malloc((size_t)size);
+	if (buf && fread(buf, 1, (size_t)size, fp) != (size_t)size)
+	{
+		free(buf);
+		buf = NULL;
+	}
+	fclose(fp);
+	*len = (size_t)size;
+	return (buf);
+}
+
+//affichage d'une partie d'un segment du journal binaire
+static void	printgame_log(t_arena *arena, const char *filename)
+{
+	unsigned char	*buf;
+	size_t			len;
+	long			n;
+	t_log_record	rec;
+	t_board			*board;
+	char			line[16];
+	int				turnbyturn;
+
+	buf = load_file(filename, &len);
+	if (buf == NULL)
+	{
+		fprintf(stderr, "Failed to open file\n");
+		exit(EXIT_FAILURE);
+	}
+	printf("Enter the game number in this log (from 1): ");
+	if (scanf("%ld", &n) != 1 || !gamelog_find(buf, len, n - 1, &rec))
+	{
+		fprintf(stderr, "No such game in %s\n", filename);
+		free(buf);
+		exit(EXIT_FAILURE);
+	}
+	board = (t_board *)arena_alloc(arena, sizeof(t_board));
+	board->size = rec.size;
+	init_board(board);
+	printf("Do you want to see the game turn by turn? (y or n): ");
+	scanf("%15s", line);
+	turnbyturn = line[0] == 'y' ? 1 : 0;
+	for (int i = 0; i < rec.nb_moves; i++)
+	{
+		if (turnbyturn)
+			print_board(board);
+		board_play(board, rec.moves[i], rec.first_player ^ (i & 1)); //les joueurs alternent a partir du premier
+	}
+	if (rec.result == LOG_RESULT_TIE)
+		printf("Tie\n");
+	else
+		printf("Player %d wins\n", rec.result + 1);
+	print_board(board);
+	free(buf);
+}
+
 //fonction d'affichage d'une partie sauvegardee
 void	printgame(t_arena *arena) //scrapping
 {
@@ -829,19 +901,24 @@ void	printgame(t_arena *arena) //scrapping
 	board = (t_board *)arena_alloc(arena, sizeof(t_board));
 	printf("Enter the game file name: ");
 	scanf("%s", filename);
-	fp = fopen(filename, "r");
+	if (strstr(filename, LOG_EXTENSION) != NULL)
+	{
+		printgame_log(arena, filename); //journal binaire
+		return ;
+	}
+	fp = fopen(filename, "r"); //ancien format texte
 	if (fp == NULL)
 	{
 		fprintf(stderr, "Failed to open file\n");
 		exit(EXIT_FAILURE);
 	}
-	if (fscanf(fp, "size:%d\n", &size) != 1)
+	if (fscanf(fp, "size:%d\n", &size) != 1 || size < 3 || size > MAX_SIZE)
 	{
 		fprintf(stderr, "Failed to read size from file\n");
 		exit(EXIT_FAILURE);
 	}
 	board->size = size;
-	init_board(arena, board);
+	init_board(board);
 	printf("Do you want to see the game turn by turn? (y or n): ");
 	scanf("%s", line);
 	turnbyturn = line[0] == 'y' ? 1 : 0;
@@ -849,9 +926,16 @@ void	printgame(t_arena *arena) //scrapping
 	{
 		if (sscanf(line, "Player %c: (%d, %d)", &player, &x, &y) == 3)
 		{
+			//coup hors du plateau ou sur une case prise : la sauvegarde est abimee
+			if (x < 1 || x > size || y < 1 || y > size
+				|| board_get(board, x - 1, y - 1) != ' ')
+			{
+				fprintf(stderr, "Invalid move in file: %s", line);
+				exit(EXIT_FAILURE);
+			}
 			if (turnbyturn)
 				print_board(board);
-			board->board[x-1][y-1] = player == '1' ? 'X' : 'O';
+			board_set(board, x-1, y-1, player == '1' ? 'X' : 'O');
 		}
 		else
 			printf("%s", line);
@@ -860,243 +944,58 @@ void	printgame(t_arena *arena) //scrapping
 	fclose(fp);
 }
 
-//fonction d'analyse des parties sauvegardees
-void	analyse_history(t_arena *arena)
+//fonction main
+int	main(int argc, char **argv)
 {
-	DIR				*d;
-	struct dirent	*dir;
-	char			filename[100];
-	FILE			*fp;
-	int				nbFiles;
-	char			**files;
-	int				i;
-	char			line[256];
-	int				size;
-	t_analyse		*analyse;
-	int				ret;
-	char			winner;
-	char			player;
-
-	nbFiles = 0;
-	analyse = (t_analyse *)arena_alloc(arena, sizeof(t_analyse));
-	d = opendir("./history");
-	if (d == NULL)
-	{
-		fprintf(stderr, "Could not open the history directory.\n");
-		exit(EXIT_FAILURE);
-	}
+	t_arena	*arena;
+	t_board	*board;
+	t_game	*game;
 
-	while ((dir = readdir(d)) != NULL)
-		nbFiles++;
-	rewinddir(d); // Reset directory stream to the beginning
-	nbFiles = nbFiles;
-	files = (char **)arena_alloc(arena, sizeof(char *) * nbFiles);
-	i = 0;
-	while ((dir = readdir(d)) != NULL)
-	{
-		files[i] = (char *)arena_alloc(arena, strlen(dir->d_name) + 1);
-		strcpy(files[i], dir->d_name);
-		i++;
-	}
-	closedir(d); // Close the directory
-	analyse->win_by_first_move = (int **)arena_alloc(arena, sizeof(int *) * 9);
-	analyse->win_by_second_move = (int **)arena_alloc(arena, sizeof(int *) * 9);
-	analyse->win_by_first_player = 0;
-	analyse->win_by_second_player = 0;
-	analyse->tie = 0;
-	analyse->nb_games = nbFiles;
-	for (int i = 0; i < 9; ++i)
-	{
-		analyse->win_by_first_move[i] = (int *)arena_alloc(arena, sizeof(int)
-			* 9);
-		memset(analyse->win_by_first_move[i], 0, sizeof(int) * 9);
   
-		analyse->win_by_second_move[i] = (int *)arena_alloc(arena, sizeof(int)
-			* 9);
-		memset(analyse->win_by_second_move[i], 0, sizeof(int) * 9);
-	}
-	for (int i = 0; i < nbFiles; i++)
+	arena = arena_init(ARENA_CHUNK_SIZE); //l'arene grandit par morceaux selon les besoins
+	if (argc > 1 && strcmp(argv[1], "book") == 0) //generation des livres d'ouvertures, sans menu
 	{
-		winner = ' ';
-		int first_move_x, first_move_y, second_move_x, second_move_y;
-		snprintf(filename, sizeof(filename), "./history/%s", files[i]);
-		//adjust_file_ownership(filename);
-		fp = fopen(filename, "r");
-		if (fp == NULL)
-		{
-			fprintf(stderr, "Failed to open file %s\n", filename);
-			arena_destroy(arena);
-			exit(EXIT_FAILURE);
-			continue ; // Skip this file and proceed to next
-		}
-		if (strstr(files[i], "game_coordinates_") != NULL)
-		{
-			if (fgets(line, sizeof(line), fp) == NULL)
-			{
-				fprintf(stderr, "Failed to read size line from file %s\n",
-					filename);
-				arena_destroy(arena);
-				fclose(fp);
-				exit(EXIT_FAILURE);
-				continue ;
-			}
-			ret = sscanf(line, "size:%d", &size);
-			if (ret != 1)
-			{
-				fprintf(stderr, "Failed to extract size from line\n");
-				arena_destroy(arena);
-				fclose(fp);
-				exit(EXIT_FAILURE);
-				continue ;
-			}
-			for (int j = 0; j < 2; j++)
-			{
-				if (fgets(line, sizeof(line), fp) == NULL)
-				{
-					if (feof(fp)) {
-						fprintf(stderr, "End of file reached for %s\n", filename);
-					} else if (ferror(fp)) {
-						perror("Error reading from file");
-					} else {
-						fprintf(stderr, "Unknown error reading from file %s\n", filename);
-					}
-					arena_destroy(arena);
-					exit(EXIT_FAILURE);
-				}
-				int x, y;
-				ret = sscanf(line, "Player %c: (%d, %d)", &player, &x, &y);
-				if (ret != 3)
-				{
-					fprintf(stderr, "2Failed to extract move from line\n");
-					arena_destroy(arena);
-					fclose(fp);
-					exit(EXIT_FAILURE);
-					continue ;
-				}
-				if (j == 0)
-				{
-					first_move_x = x-1;
-					first_move_y = y-1;
-				}
-				else
-				{
-					second_move_x = x-1;
-					second_move_y = y-1;
-				}
-			}
-  
-		}
-		while (fgets(line, sizeof(line), fp) != NULL)
-		{
-			int x, y;
-			if (sscanf(line, "Player %c: (%d, %d)", &player, &x, &y) == 3)
-				continue ;
-			else if (sscanf(line, "Player %c wins", &winner) == 1)
-			{
-				if (winner == '1')
-				{
-					analyse->win_by_first_move[first_move_x][first_move_y]++;
-					analyse->win_by_first_player++;
-				}
-				else if (winner == '2')
-				{
-					analyse->win_by_second_move[second_move_x][second_move_y]++;
-					analyse->win_by_second_player++;
-				}
-				fclose(fp);
-				break ;
-			}
-		}
+		int	ret;
+
+		ret = book_command(arena, argc - 2, argv + 2);
+		arena_destroy(arena);
+		return (ret);
 	}
-	analyse->tie = analyse->nb_games - analyse->win_by_first_player
-		- analyse->win_by_second_player;
-	analyse->nb_games -= 3; //car il y a 3 elements en + dans le dossier
-	printf("Number of games: %d\n", analyse->nb_games);
-	printf("Winrate by first player: %f\n", (float)analyse->win_by_first_player
-		/ ((float)analyse->nb_games));
-	printf("Winrate by second player: %f\n",
-		(float)analyse->win_by_second_player / ((float)analyse->nb_games));
-	printf("Tie rate: %f\n", (float)analyse->tie / ((float)analyse->nb_games
-			- 0));
-	printf("win by first player: %d\n", analyse->win_by_first_player);
-	printf("win by second player: %d\n", analyse->win_by_second_player);
-	printf("tie: %d\n\n", analyse->tie);
-	printf("Win by first move:\n");
-	for (int i = 0; i < 9; i++)
+	if (argc > 1 && strcmp(argv[1], "bench") == 0) //lot IA contre IA sans menu, resultat en JSON
 	{
-		for (int j = 0; j < 9; j++)
-		{
-			if (analyse->win_by_first_move[i][j] > 0)
-				printf("%d, %d : %d\n", i + 1, j + 1,
-					analyse->win_by_first_move[i][j]);
-		}
+		int	ret;
+
+		ret = bench_command(arena, argc - 1, argv + 1);
+		arena_destroy(arena);
+		return (ret);
 	}
-	printf("\nWin by second move:\n");
-	for (int i = 0; i < 9; i++)
+	if (argc > 1 && strcmp(argv[1], "tablebase") == 0) //generation des tables de finales
 	{
-		for (int j = 0; j < 9; j++)
-		{
-			if (analyse->win_by_second_move[i][j] > 0)
-				printf("%d, %d : %d\n", i + 1, j + 1,
-					analyse->win_by_second_move[i][j]);
-		}
-	}
-	adjust_file_ownership("./history/analyse.txt");
-	FILE *analysis_fp = fopen("./history/analyse.txt", "a");
-    if (analysis_fp == NULL)
-    {
-        fprintf(stderr, "Failed to open analysis file for writing\n");
-        exit(EXIT_FAILURE);
-    }
+		int	ret;
 
-    // Write the analysis to the file
-	fprintf(analysis_fp, "Number of games analysed: %d\n", analyse->nb_games);
-    fprintf(analysis_fp, "Winrate by first player: %f\n", (float)analyse->win_by_first_player / ((float)analyse->nb_games - 2));
-    fprintf(analysis_fp, "Winrate by second player: %f\n", (float)analyse->win_by_second_player / ((float)analyse->nb_games - 2));
-    fprintf(analysis_fp, "Tie rate: %f\n", (float)analyse->tie / ((float)analyse->nb_games - 2));
-    fprintf(analysis_fp, "win by first player: %d\n", analyse->win_by_first_player);
-    fprintf(analysis_fp, "win by second player: %d\n", analyse->win_by_second_player);
-    fprintf(analysis_fp, "tie: %d\n\n", analyse->tie);
-    fprintf(analysis_fp, "Win by first move:\n");
-    for (int i = 0; i < 9; i++)
-    {
-        for (int j = 0; j < 9; j++)
-        {
-            if (analyse->win_by_first_move[i][j] > 0)
-                fprintf(analysis_fp, "%d, %d : %d\n", i + 1, j + 1, analyse->win_by_first_move[i][j]);
-        }
-    }
-    fprintf(analysis_fp, "\nWin by second move:\n");
-    for (int i = 0; i < 9; i++)
-    {
-        for (int j = 0; j < 9; j++)
-        {
-            if (analyse->win_by_second_move[i][j] > 0)
-                fprintf(analysis_fp, "%d, %d : %d\n", i + 1, j + 1, analyse->win_by_second_move[i][j]);
-        }
-    }
-
-    // Close the analysis file
-    fclose(analysis_fp);
-}
-
-//fonction main
-int	main(void)
-{
-	t_arena	*arena;
-	t_board	*board;
-	t_game	*game;
-
-  
-	arena = arena_init(2147483647); //on lui donne une très grande partie de mémoire pour encaisser un potentiel grand nombre de parties
+		ret = tb_command(arena, argc - 2, argv + 2);
+		arena_destroy(arena);
+		return (ret);
+	}
 	board = (t_board *)arena_alloc(arena, sizeof(t_board));
 	game = (t_game *)arena_alloc(arena, sizeof(t_game));
 	set_boardsize(arena, board);
-	init_board(arena, board);
+	init_board(board);
 	set_game_mode(arena, game);
 	if (game->game_type == 5)
 	{
-		analyse_history(arena);
+		char	path[256];
+
+		char	fold[4];
+
+		printf("Log file to analyse (. for the whole history folder): ");
+		if (scanf("%255s", path) != 1)
+			strcpy(path, ".");
+		printf("Count symmetric moves together? (y/n): ");
+		if (scanf("%3s", fold) != 1)
+			fold[0] = 'n';
+		analyse_history(arena, strcmp(path, ".") == 0 ? NULL : path,
+			fold[0] == 'y');
 		arena_destroy(arena);
 		return (0);
 	}
@@ -1111,27 +1010,19 @@ int	main(void)
 		init_game(arena, game);
 		print_board(board);
 		iavsiathread(arena, board->size);
-		analyse_history(arena);
+		analyse_history(arena, NULL, 0);
 		arena_destroy(arena);
 		return (0);
 	}
 	else if (game->game_type == 2)
 	{
 		uintptr_t	game_ptr_val;
-		FILE		*fp;
-		char		filename[100];
 		print_board(board);
 		game_ptr_val = (uintptr_t)game;
-		sprintf(filename, "./history/game_coordinates_%lu.txt", game_ptr_val);
-		srand(time(NULL) + game_ptr_val);
-		fp = fopen(filename, "a");
-		if (fp == NULL)
-		{
-			fprintf(stderr, "Failed to open file for writing\n");
-			exit(EXIT_FAILURE);
-		}
-		fprintf(fp, "size:%d\n", board->size);
-		fclose(fp);
+		game->id = game_ptr_val;
+		rng_seed(&game->rng, (uint64_t)time(NULL) ^ game_ptr_val);
+		game->log = (t_gamelog *)arena_alloc(arena, sizeof(t_gamelog));
+		gamelog_open(game->log); //la partie sera ecrite en une fois a la fin
 		//ask the user if he wants to play first or second
 		printf("Do you want to play first or second? (1 or 2): ");
 		char	*input;
@@ -1148,6 +1039,11 @@ int	main(void)
 			game->player_turn = atoi(input);
 		}
 		game->player_turn--;
+		game->first_player = game->player_turn;
+		t_ai_config	ai;
+
+		ask_ai(&ai, "AI");
+		ai_create(arena, game, 1, &ai, ai_create_tt(arena, &ai, 1));
 		while (1)
 		{
 			play_one_turn(arena, board, game);
@@ -1159,20 +1055,12 @@ int	main(void)
 	else
 	{
 		uintptr_t	game_ptr_val;
-		FILE		*fp;
-		char		filename[100];
 		print_board(board);
 		game_ptr_val = (uintptr_t)game;
-		sprintf(filename, "./history/game_coordinates_%lu.txt", game_ptr_val);
-		srand(time(NULL) + game_ptr_val);
-		fp = fopen(filename, "a");
-		if (fp == NULL)
-		{
-			fprintf(stderr, "Failed to open file for writing\n");
-			exit(EXIT_FAILURE);
-		}
-		fprintf(fp, "size:%d\n", board->size);
-		fclose(fp);
+		game->id = game_ptr_val;
+		rng_seed(&game->rng, (uint64_t)time(NULL) ^ game_ptr_val);
+		game->log = (t_gamelog *)arena_alloc(arena, sizeof(t_gamelog));
+		gamelog_open(game->log); //la partie sera ecrite en une fois a la fin
 		while (1)
 		{
 			play_one_turn(arena, board, game);
@@ -0,0 +1,272 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "tictactoe.h"
+
+#define MCTS_NODES (1 << 21) //taille de la reserve de noeuds d'un moteur
+#define MCTS_EXPAND 4 //visites avant de developper un noeud (la racine l'est tout de suite)
+#define MCTS_UCT 1.0 //poids de l'exploration dans UCT
+#define MCTS_CHECK 64 //parties aleatoires entre deux lectures de l'horloge
+#define MCTS_NEW 0
+#define MCTS_EXPANDING 1
+#define MCTS_EXPANDED 2
+#define MCTS_LEAF 3 //reserve pleine : le noeud ne sera jamais developpe
+
+static double	mcts_now(void)
+{
+	struct timespec	ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((double)ts.tv_sec + (double)ts.tv_nsec / 1e9);
+}
+
+static void	*mcts_helper(void *arg);
+
+//prepare un moteur Monte Carlo : reserve de noeuds et plateaux de travail pris une fois dans l'arene
+//les threads auxiliaires sont lances ici et attendent chaque coup jusqu'a mcts_free
+void	mcts_init(t_arena *arena, t_mcts *m, const t_ai_config *ai, uint64_t seed)
+{
+	m->nb_threads = ai->nb_threads > 0 ? ai->nb_threads : default_nb_workers();
+	m->max_playouts = ai->playouts;
+	m->max_ms = ai->time_ms > 0 ? ai->time_ms : 1000;
+	m->max_nodes = MCTS_NODES;
+	m->nodes = (t_mcts_node *)arena_alloc(arena, sizeof(t_mcts_node) * MCTS_NODES);
+	m->threads = (t_mcts_thread *)arena_alloc(arena, sizeof(t_mcts_thread)
+			* m->nb_threads);
+	if (m->nodes == NULL || m->threads == NULL)
+	{
+		fprintf(stderr, "Not enough memory for the MCTS tree\n");
+		exit(EXIT_FAILURE);
+	}
+	for (int i = 0; i < m->nb_threads; i++)
+	{
+		m->threads[i].mcts = m;
+		rng_seed(&m->threads[i].rng, seed + (uint64_t)i); //splitmix64 separe les graines voisines
+	}
+	pthread_mutex_init(&m->lock, NULL);
+	pthread_cond_init(&m->start, NULL);
+	pthread_cond_init(&m->done, NULL);
+	m->generation = 0;
+	m->running = 0;
+	m->stop = 0;
+	for (int i = 1; i < m->nb_threads; i++)
+		pthread_create(&m->threads[i].thread, NULL, mcts_helper, m->threads + i);
+}
+
+static void	mcts_new_node(t_mcts_node *n, int move)
+{
+	atomic_init(&n->visits, 0);
+	atomic_init(&n->score, 0);
+	atomic_init(&n->state, MCTS_NEW);
+	n->first_child = 0;
+	n->nb_children = 0;
+	n->move = (unsigned char)move;
+}
+
+//developpe un noeud : un fils par case libre, pris dans la reserve sans verrou
+//un seul thread gagne le droit de le faire, les autres continuent avec une partie aleatoire
+static int	mcts_expand(t_mcts *m, t_mcts_node *n, t_board *board)
+{
+	t_bitboard	occupied;
+	int			expected;
+	int			first;
+	int			k;
+
+	expected = MCTS_NEW;
+	if (!atomic_compare_exchange_strong(&n->state, &expected, MCTS_EXPANDING))
+		return (0);
+	first = atomic_load(&m->nb_nodes);
+	do
+	{
+		if (first + board->empty > m->max_nodes)
+		{
+			atomic_store(&n->state, MCTS_LEAF);
+			return (0);
+		}
+	}
+	while (!atomic_compare_exchange_weak(&m->nb_nodes, &first,
+			first + board->empty));
+	occupied = board->bits[0] | board->bits[1];
+	k = first;
+	for (int cell = 0; cell < board->size * board->size; cell++)
+		if (!(occupied & ((t_bitboard)1 << cell)))
+			mcts_new_node(&m->nodes[k++], cell);
+	n->first_child = first;
+	n->nb_children = (unsigned char)board->empty;
+	atomic_store_explicit(&n->state, MCTS_EXPANDED, memory_order_release); //les fils sont prets
+	return (1);
+}
+
+//fils qui maximise UCT ; un fils jamais visite passe avant les autres
+//les descentes en cours comptent deja comme des visites sans gain : c'est la perte virtuelle
+//qui ecarte les autres threads du meme chemin
+static int	mcts_select(t_mcts *m, t_mcts_node *n)
+{
+	double	log_n;
+	double	value;
+	double	best_value;
+	int		best;
+	int		visits;
+
+	log_n = log((double)atomic_load_explicit(&n->visits, memory_order_relaxed) + 1.0);
+	best = n->first_child;
+	best_value = -1.0;
+	for (int i = n->first_child; i < n->first_child + n->nb_children; i++)
+	{
+		visits = atomic_load_explicit(&m->nodes[i].visits, memory_order_relaxed);
+		if (visits == 0)
+			return (i);
+		value = atomic_load_explicit(&m->nodes[i].score, memory_order_relaxed)
+			/ (2.0 * visits) + MCTS_UCT * sqrt(log_n / visits);
+		if (value > best_value)
+		{
+			best_value = value;
+			best = i;
+		}
+	}
+	return (best);
+}
+
+//partie aleatoire jusqu'a la fin, avec le tirage de tourOrdinateur ; renvoie le gagnant ou -1
+static int	mcts_rollout(t_board *board, int player, t_rng *rng)
+{
+	while (board->winner == -1 && board->empty > 0)
+	{
+		board_play(board, board_random_cell(board, rng), player);
+		player ^= 1;
+	}
+	return (board->winner);
+}
+
+static int	mcts_budget_left(t_mcts *m, long done)
+{
+	if (m->max_playouts > 0)
+		return (done < m->max_playouts);
+	return (done % MCTS_CHECK != 0 || mcts_now() < m->deadline);
+}
+
+//boucle d'un thread : descente UCT, developpement, partie aleatoire sur son plateau, remontee
+static void	*mcts_thread(void *arg)
+{
+	t_mcts_thread	*t;
+	t_mcts			*m;
+	int				path[MAX_CELLS + 1];
+	int				depth;
+	int				node;
+	int				player;
+	int				winner;
+
+	t = (t_mcts_thread *)arg;
+	m = t->mcts;
+	while (mcts_budget_left(m, atomic_fetch_add(&m->playouts, 1)))
+	{
+		memcpy(&t->board, m->root, sizeof(t_board)); //aucune allocation pendant la recherche
+		player = m->player;
+		node = 0;
+		depth = 0;
+		atomic_fetch_add_explicit(&m->nodes[0].visits, 1, memory_order_relaxed);
+		path[depth++] = 0;
+		while (t->board.winner == -1 && t->board.empty > 0)
+		{
+			if (atomic_load_explicit(&m->nodes[node].state, memory_order_acquire)
+				!= MCTS_EXPANDED)
+			{
+				if (node != 0 && atomic_load_explicit(&m->nodes[node].visits,
+						memory_order_relaxed) < MCTS_EXPAND)
+					break ;
+				if (!mcts_expand(m, &m->nodes[node], &t->board))
+					break ; //deja en cours de developpement par un autre thread, ou reserve pleine
+			}
+			node = mcts_select(m, &m->nodes[node]);
+			atomic_fetch_add_explicit(&m->nodes[node].visits, 1, memory_order_relaxed);
+			board_play(&t->board, m->nodes[node].move, player);
+			player ^= 1;
+			path[depth++] = node;
+		}
+		winner = mcts_rollout(&t->board, player, &t->rng);
+		for (int k = 1; k < depth; k++) //le noeud k a ete joue par le joueur de la racine si k est impair
+		{
+			if (winner == -1)
+				atomic_fetch_add_explicit(&m->nodes[path[k]].score, 1, memory_order_relaxed);
+			else if (winner == (m->player ^ ((k + 1) & 1)))
+				atomic_fetch_add_explicit(&m->nodes[path[k]].score, 2, memory_order_relaxed);
+		}
+	}
+	return (NULL);
+}
+
+//thread auxiliaire : attend un coup, cherche avec les autres, puis se rendort jusqu'au suivant
+static void	*mcts_helper(void *arg)
+{
+	t_mcts			*m;
+	unsigned long	seen;
+
+	m = ((t_mcts_thread *)arg)->mcts;
+	seen = 0;
+	pthread_mutex_lock(&m->lock);
+	while (1)
+	{
+		while (!m->stop && m->generation == seen)
+			pthread_cond_wait(&m->start, &m->lock);
+		if (m->stop)
+			break ;
+		seen = m->generation;
+		pthread_mutex_unlock(&m->lock);
+		mcts_thread(arg);
+		pthread_mutex_lock(&m->lock);
+		if (--m->running == 0)
+			pthread_cond_signal(&m->done);
+	}
+	pthread_mutex_unlock(&m->lock);
+	return (NULL);
+}
+
+//arrete les threads auxiliaires ; la memoire du moteur reste a l'arene
+void	mcts_free(t_mcts *m)
+{
+	pthread_mutex_lock(&m->lock);
+	m->stop = 1;
+	pthread_cond_broadcast(&m->start);
+	pthread_mutex_unlock(&m->lock);
+	for (int i = 1; i < m->nb_threads; i++)
+		pthread_join(m->threads[i].thread, NULL);
+	pthread_cond_destroy(&m->start);
+	pthread_cond_destroy(&m->done);
+	pthread_mutex_destroy(&m->lock);
+}
+
+//choisit le coup de player : les threads developpent un arbre commun jusqu'au budget
+//puis on joue le fils de la racine le plus visite
+int	mcts_best_move(t_mcts *m, t_board *board, int player)
+{
+	t_mcts_node	*root;
+	int			best;
+
+	m->root = board;
+	m->player = player;
+	mcts_new_node(&m->nodes[0], 0);
+	atomic_store(&m->nb_nodes, 1);
+	atomic_store(&m->playouts, 0);
+	m->deadline = mcts_now() + (double)m->max_ms / 1000.0;
+	pthread_mutex_lock(&m->lock); //reveille les threads auxiliaires deja lances
+	m->running = m->nb_threads - 1;
+	m->generation++;
+	pthread_cond_broadcast(&m->start);
+	pthread_mutex_unlock(&m->lock);
+	mcts_thread(m->threads); //le thread appelant travaille aussi
+	pthread_mutex_lock(&m->lock);
+	while (m->running > 0)
+		pthread_cond_wait(&m->done, &m->lock);
+	pthread_mutex_unlock(&m->lock);
+	root = &m->nodes[0];
+	if (atomic_load(&root->state) != MCTS_EXPANDED)
+		return (board_random_cell(board, &m->threads[0].rng));
+	best = root->first_child;
+	for (int i = root->first_child; i < root->first_child + root->nb_children; i++)
+		if (atomic_load(&m->nodes[i].visits) > atomic_load(&m->nodes[best].visits))
+			best = i;
+	return (m->nodes[best].move);
+}
@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "tictactoe.h"
+
+static const char	*g_phases[PROF_NB_PHASES] = {"sem_wait", "mutex_wait", "move",
+	"game_done", "log_push", "log_write"};
+
+static _Thread_local t_prof	*g_prof; //histogrammes du thread courant, NULL s'il n'est pas suivi
+
+//horloge monotone en nanosecondes
+uint64_t	prof_now(void)
+{
+	struct timespec	ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+}
+
+//le thread courant enregistre desormais ses durees dans p, sans verrou
+void	prof_attach(t_prof *p)
+{
+	g_prof = p;
+}
+
+//case d'une duree : 16 cases exactes, puis 16 cases par puissance de 2 (6 % d'erreur au plus)
+static int	prof_bucket(uint64_t ns)
+{
+	int	e;
+
+	if (ns < PROF_SUB_BUCKETS)
+		return ((int)ns);
+	e = 63 - __builtin_clzll(ns);
+	return ((e - 3) * PROF_SUB_BUCKETS + (int)((ns >> (e - 4)) & (PROF_SUB_BUCKETS - 1)));
+}
+
+//plus grande duree d'une case
+static uint64_t	prof_bucket_max(int b)
+{
+	int	e;
+
+	if (b < PROF_SUB_BUCKETS)
+		return ((uint64_t)b);
+	e = b / PROF_SUB_BUCKETS + 3;
+	return (((uint64_t)(PROF_SUB_BUCKETS + b % PROF_SUB_BUCKETS + 1) << (e - 4)) - 1);
+}
+
+//ajoute une duree a un histogramme
+void	prof_hist_add(t_prof_hist *h, uint64_t ns)
+{
+	h->count++;
+	h->total += ns;
+	if (ns > h->max)
+		h->max = ns;
+	h->buckets[prof_bucket(ns)]++;
+}
+
+//ajoute la duree ecoulee depuis start a la phase du thread courant
+void	prof_record(int phase, uint64_t start)
+{
+	uint64_t	ns;
+
+	ns = prof_now() - start;
+#ifdef TTT_TRACE
+	trace_record(phase, start, ns); //meme point de mesure pour le journal de bord
+#endif
+	if (g_prof == NULL)
+		return ;
+	prof_hist_add(&g_prof->hist[phase], ns);
+}
+
+//nom d'une phase dans les rapports
+const char	*prof_phase_name(int phase)
+{
+	return (g_phases[phase]);
+}
+
+//ajoute un histogramme a un autre
+void	prof_hist_merge(t_prof_hist *dst, const t_prof_hist *src)
+{
+	dst->count += src->count;
+	dst->total += src->total;
+	if (src->max > dst->max)
+		dst->max = src->max;
+	for (int b = 0; b < PROF_BUCKETS; b++)
+		dst->buckets[b] += src->buckets[b];
+}
+
+//ajoute les histogrammes d'un thread a ceux du lot
+void	prof_merge(t_prof *dst, const t_prof *src)
+{
+	for (int p = 0; p < PROF_NB_PHASES; p++)
+		prof_hist_merge(dst->hist + p, src->hist + p);
+}
+
+//duree sous laquelle tombent q pour mille des mesures
+uint64_t	prof_percentile(const t_prof_hist *h, int q)
+{
+	uint64_t	rank;
+	uint64_t	seen;
+
+	rank = (h->count * (uint64_t)q + 999) / 1000;
+	seen = 0;
+	for (int b = 0; b < PROF_BUCKETS; b++)
+	{
+		seen += h->buckets[b];
+		if (seen >= rank && seen > 0)
+			return (prof_bucket_max(b) < h->max ? prof_bucket_max(b) : h->max);
+	}
+	return (h->max);
+}
+
+//p50, p99 et p999 de chaque phase mesuree, en nanosecondes
+void	prof_report(const t_prof *p)
+{
+	const t_prof_hist	*h;
+
+	fprintf(stderr, "%-12s %12s %10s %10s %10s %10s %12s\n", "phase", "count", "mean_ns",
+		"p50_ns", "p99_ns", "p999_ns", "max_ns");
+	for (int i = 0; i < PROF_NB_PHASES; i++)
+	{
+		h = &p->hist[i];
+		if (h->count == 0)
+			continue ;
+		fprintf(stderr, "%-12s %12lu %10lu %10lu %10lu %10lu %12lu\n", g_phases[i],
+			(unsigned long)h->count, (unsigned long)(h->total / h->count),
+			(unsigned long)prof_percentile(h, 500), (unsigned long)prof_percentile(h, 990),
+			(unsigned long)prof_percentile(h, 999), (unsigned long)h->max);
+	}
+}
@@ -0,0 +1,58 @@
+#include "tictactoe.h"
+
+//generateur splitmix64 : sert a etaler une graine sur tout l'etat des autres generateurs
+uint64_t	splitmix64(uint64_t *state)
+{
+	uint64_t	z;
+
+	z = (*state += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return (z ^ (z >> 31));
+}
+
+//prepare un generateur : deux graines differentes donnent deux suites independantes
+void	rng_seed(t_rng *rng, uint64_t seed)
+{
+	for (int i = 0; i < 4; i++)
+		rng->s[i] = splitmix64(&seed);
+}
+
+//graine numero index tiree d'une graine maitresse : la meme quel que soit l'ordre des tirages
+uint64_t	rng_derive(uint64_t master, uint64_t index)
+{
+	uint64_t	state;
+
+	state = master + index * 0x9E3779B97F4A7C15ULL;
+	return (splitmix64(&state));
+}
+
+static uint64_t	rotl(uint64_t x, int k)
+{
+	return ((x << k) | (x >> (64 - k)));
+}
+
+//xoshiro256** : quelques decalages et une multiplication, sans verrou ni etat global
+uint64_t	rng_next(t_rng *rng)
+{
+	uint64_t	*s;
+	uint64_t	result;
+	uint64_t	t;
+
+	s = rng->s;
+	result = rotl(s[1] * 5, 7) * 9;
+	t = s[1] << 17;
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = rotl(s[3], 45);
+	return (result);
+}
+
+//entier dans [0, n) : multiplication par n des 32 bits de poids fort, sans division
+unsigned int	rng_below(t_rng *rng, unsigned int n)
+{
+	return ((unsigned int)(((rng_next(rng) >> 32) * (uint64_t)n) >> 32));
+}
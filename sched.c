@@ -0,0 +1,134 @@
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "tictactoe.h"
+
+static int	g_core_cpus[CPU_SETSIZE][SCHED_MAX_SMT]; //processeurs logiques de chaque coeur physique
+static int	g_core_size[CPU_SETSIZE];
+static int	g_core_key[CPU_SETSIZE]; //paquet et numero du coeur
+static int	g_nb_cores;
+
+// fonction qui definit la politique d ordonnancement
+// renvoie 0, ou le code d'erreur (EPERM sans les droits du temps reel) : l'appelant decide quoi en faire
+int set_thread_policy_and_priority(pthread_t thread, int policy, int priority) {
+    struct sched_param param;
+    param.sched_priority = priority;
+    return (pthread_setschedparam(thread, policy, &param));
+}
+
+//attache un thread a un processeur logique, renvoie 0 ou le code d'erreur
+int	set_thread_affinity(pthread_t thread, int cpu)
+{
+	cpu_set_t	set;
+
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	return (pthread_setaffinity_np(thread, sizeof(set), &set));
+}
+
+//essaie une politique sur le thread courant puis remet l'ancienne : 0 si le systeme l'accepte
+int	sched_probe(int policy, int priority)
+{
+	struct sched_param	old;
+	int					old_policy;
+	int					err;
+
+	err = pthread_getschedparam(pthread_self(), &old_policy, &old);
+	if (err != 0)
+		return (err);
+	err = set_thread_policy_and_priority(pthread_self(), policy, priority);
+	if (err == 0)
+		pthread_setschedparam(pthread_self(), old_policy, &old);
+	return (err);
+}
+
+//numero lu dans /sys/devices/system/cpu/cpuN/topology, -1 s'il n'existe pas
+static int	read_topology(int cpu, const char *name)
+{
+	char	path[96];
+	FILE	*fp;
+	int		id;
+
+	snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/%s", cpu, name);
+	fp = fopen(path, "r");
+	if (fp == NULL)
+		return (-1);
+	if (fscanf(fp, "%d", &id) != 1)
+		id = -1;
+	fclose(fp);
+	return (id);
+}
+
+//regroupe par coeur physique les processeurs que le processus a le droit d'utiliser
+//sans topologie lisible, chaque processeur logique compte pour un coeur
+static void	sched_topology(void)
+{
+	cpu_set_t	allowed;
+	int			core;
+	int			key;
+	int			i;
+
+	if (g_nb_cores > 0)
+		return ;
+	if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+	{
+		CPU_ZERO(&allowed);
+		for (int cpu = 0; cpu < default_nb_workers() && cpu < CPU_SETSIZE; cpu++)
+			CPU_SET(cpu, &allowed);
+	}
+	for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+	{
+		if (!CPU_ISSET(cpu, &allowed))
+			continue ;
+		core = read_topology(cpu, "core_id");
+		key = core < 0 ? -1 - cpu : read_topology(cpu, "physical_package_id") * 65536 + core;
+		i = 0;
+		while (i < g_nb_cores && g_core_key[i] != key)
+			i++;
+		if (i == g_nb_cores)
+			g_core_key[g_nb_cores++] = key;
+		if (g_core_size[i] < SCHED_MAX_SMT)
+			g_core_cpus[i][g_core_size[i]++] = cpu;
+	}
+	if (g_nb_cores == 0) //masque vide : on se contente du processeur 0
+	{
+		g_core_size[0] = 1;
+		g_nb_cores = 1;
+	}
+}
+
+//processeur du thread player (sur per_worker) du worker, -1 pour laisser le systeme choisir
+//a appeler avant de lancer les threads : la topologie est lue une fois, sans verrou
+//s'il n'y a pas assez de coeurs ou pas d'hyperthreads, les placements se replient sur les coeurs qui existent
+int	sched_place_cpu(int placement, int worker, int player, int per_worker)
+{
+	int	core;
+
+	if (placement == PLACE_OS)
+		return (-1);
+	sched_topology();
+	if (placement == PLACE_SEPARATE)
+	{
+		core = (worker * per_worker + player) % g_nb_cores;
+		return (g_core_cpus[core][0]);
+	}
+	core = worker % g_nb_cores;
+	if (placement == PLACE_SIBLINGS)
+		return (g_core_cpus[core][player % g_core_size[core]]);
+	return (g_core_cpus[core][0]);
+}
+
+//nombre de workers par defaut : un par coeur disponible
+int	default_nb_workers(void)
+{
+	long	n;
+
+	n = sysconf(_SC_NPROCESSORS_ONLN);
+	if (n < 1)
+		return (1);
+	return ((int)n);
+}
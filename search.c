@@ -0,0 +1,313 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "tictactoe.h"
+
+#define SEARCH_WIN 1000000 //score d'une victoire, moins le nombre de coups pour y arriver
+#define SEARCH_INF (SEARCH_WIN + 1)
+#define SEARCH_MATE (SEARCH_WIN - 2 * MAX_CELLS) //au dela, le score est une fin de partie forcee
+#define SEARCH_NODES (1L << 19) //budget de positions par coup (feuilles comprises)
+#define SIDE_KEY 0x5D1F2A6C3B9E8471ULL //ajoute a la cle quand c'est a O de jouer
+#define TT_EXACT 0
+#define TT_LOWER 1 //le vrai score est au moins celui stocke (coupure beta)
+#define TT_UPPER 2 //le vrai score est au plus celui stocke (aucun coup n'a depasse alpha)
+
+//poids d'une ligne encore ouverte selon le nombre de symboles deja poses dessus
+static const int	g_line_weight[5] = {0, 1, 8, 64, 512};
+
+//prepare une IA du niveau donne, qui range ses positions dans la table partagee tt
+//seed donne le melange des coups a la racine
+void	search_init(t_search *s, int level, t_tt *tt, uint64_t seed)
+{
+	s->max_depth = MAX_CELLS;
+	if (level == AI_LEVEL_EASY)
+		s->max_depth = 2;
+	else if (level == AI_LEVEL_MEDIUM)
+		s->max_depth = 4;
+	s->max_nodes = SEARCH_NODES;
+	s->size = 0;
+	s->tt = tt;
+	memset(&s->stats, 0, sizeof(s->stats));
+	rng_seed(&s->rng, seed);
+}
+
+//ordre des coups (les cases qui portent le plus de lignes d'abord) et voisinages d'une taille
+static void	search_prepare(t_search *s, int size)
+{
+	const t_winmasks	*w;
+	int					key[MAX_CELLS];
+	int					cell;
+	int					j;
+
+	w = get_winmasks(size);
+	for (int i = 0; i < size * size; i++)
+	{
+		key[i] = w->cell_nb_lines[i] * 4 * MAX_CELLS
+			- abs(2 * (i / size) - size + 1) - abs(2 * (i % size) - size + 1);
+		j = i;
+		while (j > 0 && key[s->order[j - 1]] < key[i])
+		{
+			s->order[j] = s->order[j - 1];
+			j--;
+		}
+		s->order[j] = (unsigned char)i;
+		s->near[i] = 0;
+		for (int dl = -1; dl <= 1; dl++)
+			for (int dc = -1; dc <= 1; dc++)
+				if ((dl || dc) && i / size + dl >= 0 && i / size + dl < size
+					&& i % size + dc >= 0 && i % size + dc < size)
+				{
+					cell = (i / size + dl) * size + i % size + dc;
+					s->near[i] |= (t_bitboard)1 << cell;
+				}
+	}
+	s->size = size;
+}
+
+//1 si jouer dans cell fait gagner player : une ligne de la case n'attend plus que ce symbole
+static int	wins_at(t_board *board, int cell, int player)
+{
+	const t_winmasks	*w;
+
+	w = board->masks;
+	for (int i = 0; i < w->cell_nb_lines[cell]; i++)
+		if (board->line_count[player][w->cell_lines[cell][i]] == w->sequence - 1)
+			return (1);
+	return (0);
+}
+
+//evaluation d'une position non terminee du point de vue de player : lignes encore ouvertes
+static int	evaluate(t_board *board, int player)
+{
+	const unsigned char	*mine;
+	const unsigned char	*theirs;
+	int					score;
+
+	mine = board->line_count[player];
+	theirs = board->line_count[player ^ 1];
+	score = 0;
+	for (int i = 0; i < board->masks->nb_lines; i++)
+	{
+		if (theirs[i] == 0)
+			score += g_line_weight[mine[i]];
+		else if (mine[i] == 0)
+			score -= g_line_weight[theirs[i]];
+	}
+	return (score);
+}
+
+//coups a essayer : celui de la table d'abord, puis les cases libres du centre vers les bords
+//au dela de 4*4, seules les cases voisines d'un symbole deja pose sont essayees
+static int	gen_moves(t_search *s, t_board *board, int first, unsigned char *moves)
+{
+	t_bitboard	occupied;
+	int			nb;
+	int			cell;
+
+	occupied = board->bits[0] | board->bits[1];
+	nb = 0;
+	if (first >= 0 && !(occupied & ((t_bitboard)1 << first)))
+		moves[nb++] = (unsigned char)first;
+	for (int i = 0; i < board->size * board->size; i++)
+	{
+		cell = s->order[i];
+		if (cell == first || (occupied & ((t_bitboard)1 << cell)))
+			continue ;
+		if (board->size > 4 && occupied && !(s->near[cell] & occupied))
+			continue ;
+		moves[nb++] = (unsigned char)cell;
+	}
+	return (nb);
+}
+
+//les scores de fin de partie sont stockes par rapport a la position, pas a la racine
+static int	score_to_tt(int score, int ply)
+{
+	if (score > SEARCH_MATE)
+		return (score + ply);
+	if (score < -SEARCH_MATE)
+		return (score - ply);
+	return (score);
+}
+
+static int	score_from_tt(int score, int ply)
+{
+	if (score > SEARCH_MATE)
+		return (score - ply);
+	if (score < -SEARCH_MATE)
+		return (score + ply);
+	return (score);
+}
+
+//les coups gagnants tout de suite sont traites sans recherche : on gagne, ou on pare la seule menace
+//renvoie le score si la position est jouee d'avance, sinon 0 et nb devient le nombre de coups a essayer
+static int	forced_moves(t_board *board, int player, unsigned char *moves,
+	int *nb, int ply)
+{
+	int	threat;
+	int	nb_threats;
+
+	nb_threats = 0;
+	threat = 0;
+	for (int i = 0; i < *nb; i++)
+	{
+		if (wins_at(board, moves[i], player))
+			return (SEARCH_WIN - ply - 1);
+		if (wins_at(board, moves[i], player ^ 1))
+		{
+			threat = moves[i];
+			nb_threats++;
+		}
+	}
+	if (nb_threats >= 2)
+		return (-(SEARCH_WIN - ply - 2)); //deux menaces : l'adversaire gagne au coup suivant
+	if (nb_threats == 1)
+	{
+		moves[0] = (unsigned char)threat;
+		*nb = 1;
+	}
+	return (0);
+}
+
+//cle de la position quand player a le trait : canonique, pour que les 8 images partagent
+//leurs entrees (table de transposition, livre d'ouvertures) ; sym recoit la symetrie utilisee
+uint64_t	search_key(t_board *board, int player, int *sym)
+{
+	return (board_canonical_key(board, sym) ^ (player ? SIDE_KEY : 0));
+}
+
+//negamax avec coupures alpha-beta : score de la position pour player, qui a le trait
+static int	negamax(t_search *s, t_board *board, int player, int depth,
+	int alpha, int beta, int ply)
+{
+	unsigned char	moves[MAX_CELLS];
+	t_tt_entry		e;
+	uint64_t		key;
+	int				sym;
+	int				nb;
+	int				best;
+	int				best_move;
+	int				score;
+	int				alpha0;
+
+	if (++s->nodes >= s->max_nodes)
+	{
+		s->stop = 1;
+		return (0);
+	}
+	if (board->empty == 0)
+		return (0);
+	if (depth == 0)
+		return (evaluate(board, player));
+	key = search_key(board, player, &sym);
+	best_move = -1;
+	if (tt_probe(s->tt, key, &e, &s->stats))
+	{
+		best_move = board->masks->sym[sym_inverse(sym)][e.move]; //le coup est range dans le repere canonique
+		score = score_from_tt(e.score, ply);
+		if (e.depth >= depth && (e.flag == TT_EXACT
+				|| (e.flag == TT_LOWER && score >= beta)
+				|| (e.flag == TT_UPPER && score <= alpha)))
+			return (score);
+	}
+	nb = gen_moves(s, board, best_move, moves);
+	score = forced_moves(board, player, moves, &nb, ply);
+	if (score != 0)
+		return (score);
+	alpha0 = alpha;
+	best = -SEARCH_INF;
+	for (int i = 0; i < nb && alpha < beta; i++)
+	{
+		board_play(board, moves[i], player);
+		score = -negamax(s, board, player ^ 1, depth - 1, -beta, -alpha, ply + 1);
+		board_undo(board, moves[i], player);
+		if (s->stop)
+			return (0);
+		if (score > best)
+		{
+			best = score;
+			best_move = moves[i];
+		}
+		if (best > alpha)
+			alpha = best;
+	}
+	e.score = score_to_tt(best, ply);
+	e.depth = (signed char)depth;
+	e.flag = best <= alpha0 ? TT_UPPER : best >= beta ? TT_LOWER : TT_EXACT;
+	e.move = board->masks->sym[sym][best_move];
+	tt_store(s->tt, key, &e, &s->stats);
+	return (best);
+}
+
+//choisit le coup de player : approfondissement iteratif jusqu'a la profondeur du niveau
+//ou jusqu'a epuisement du budget (on garde alors le coup de la derniere iteration complete)
+//les coups de la racine sont melanges pour varier les parties entre coups de meme valeur
+int	search_best_move(t_search *s, t_board *board, int player)
+{
+	unsigned char	moves[MAX_CELLS];
+	unsigned char	tmp;
+	int				nb;
+	int				best_move;
+	int				iter_move;
+	int				alpha;
+	int				score;
+
+	if (s->size != board->size)
+		search_prepare(s, board->size);
+	s->nodes = 0;
+	s->stop = 0;
+	tt_new_search(s->tt);
+	nb = gen_moves(s, board, -1, moves);
+	for (int i = nb - 1; i > 0; i--)
+	{
+		score = (int)rng_below(&s->rng, (unsigned int)(i + 1));
+		tmp = moves[i];
+		moves[i] = moves[score];
+		moves[score] = tmp;
+	}
+	if (forced_moves(board, player, moves, &nb, 0) > 0)
+	{
+		s->score = SEARCH_WIN - 1;
+		for (int i = 0; i < nb; i++)
+			if (wins_at(board, moves[i], player))
+				return (moves[i]);
+	}
+	best_move = moves[0];
+	alpha = 0;
+	s->score = 0;
+	for (int depth = 1; depth <= s->max_depth && depth <= board->empty; depth++)
+	{
+		alpha = -SEARCH_INF;
+		iter_move = best_move;
+		for (int i = 0; i < nb; i++)
+		{
+			board_play(board, moves[i], player);
+			score = -negamax(s, board, player ^ 1, depth - 1, -SEARCH_INF,
+					-alpha, 1);
+			board_undo(board, moves[i], player);
+			if (s->stop)
+				break ;
+			if (score > alpha)
+			{
+				alpha = score;
+				iter_move = moves[i];
+			}
+		}
+		if (s->stop)
+			break ;
+		best_move = iter_move;
+		s->score = alpha;
+		for (int i = 1; i < nb; i++) //le meilleur coup est essaye en premier a l'iteration suivante
+		{
+			if (moves[i] == best_move)
+			{
+				moves[i] = moves[0];
+				moves[0] = (unsigned char)best_move;
+			}
+		}
+		if (alpha > SEARCH_MATE || alpha < -SEARCH_MATE)
+			break ; //fin de partie forcee : chercher plus loin ne changera rien
+	}
+	tt_flush_stats(s->tt, &s->stats);
+	return (best_move);
+}
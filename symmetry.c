@@ -0,0 +1,60 @@
+#include "tictactoe.h"
+
+//symetrie inverse : seuls les quarts de tour ne sont pas leur propre inverse
+int	sym_inverse(int s)
+{
+	if (s == 1 || s == 3)
+		return (4 - s);
+	return (s);
+}
+
+//image de la case (l, c) par la symetrie s : identite, 3 rotations, 4 reflexions
+int	sym_cell(int size, int s, int l, int c)
+{
+	int	n;
+
+	n = size - 1;
+	if (s == 1)
+		return (c * size + n - l); //quart de tour
+	if (s == 2)
+		return ((n - l) * size + n - c); //demi-tour
+	if (s == 3)
+		return ((n - c) * size + l); //trois quarts de tour
+	if (s == 4)
+		return (l * size + n - c); //miroir gauche-droite
+	if (s == 5)
+		return ((n - l) * size + c); //miroir haut-bas
+	if (s == 6)
+		return (c * size + l); //diagonale
+	if (s == 7)
+		return ((n - c) * size + n - l); //anti-diagonale
+	return (l * size + c);
+}
+
+//cle Zobrist canonique : la plus petite des cles vues par les 8 symetries, toutes tenues a jour
+//par board_play ; sym recoit la symetrie qui y mene
+uint64_t	board_canonical_key(t_board *board, int *sym)
+{
+	int	best;
+
+	best = 0;
+	for (int s = 1; s < NB_SYMMETRIES; s++)
+		if (board->hash[s] < board->hash[best])
+			best = s;
+	*sym = best;
+	return (board->hash[best]);
+}
+
+//representant d'une case parmi ses images : les 4 coins comptent comme un seul coup
+int	sym_canonical_cell(int size, int cell)
+{
+	const t_winmasks	*w;
+	int					best;
+
+	w = get_winmasks(size);
+	best = cell;
+	for (int s = 1; s < NB_SYMMETRIES; s++)
+		if (w->sym[s][cell] < best)
+			best = w->sym[s][cell];
+	return (best);
+}
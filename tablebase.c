@@ -0,0 +1,449 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "tictactoe.h"
+
+//valeur d'une position pour le joueur qui a le trait : 2 bits de resultat, 6 bits de distance
+#define TB_ILLEGAL 0 //position impossible (le joueur qui a le trait a deja aligne)
+#define TB_WIN 1
+#define TB_LOSS 2
+#define TB_DRAW 3
+#define TB_VALUE(r, d) ((unsigned char)((r) << 6 | (d)))
+#define TB_RESULT(v) ((v) >> 6)
+#define TB_DIST(v) ((v) & 63) //coups jusqu'a la fin de la partie avec le meilleur jeu
+
+//travail partage par les threads d'une couche
+typedef struct
+{
+	int					size;
+	long				nb; //3^(size*size) positions
+	long				pow3[MAX_TB_CELLS + 1];
+	unsigned char		*values;
+	unsigned char		*stones; //nombre de symboles de chaque position
+	t_arena				*arena;
+	int					layer; //couche en cours : positions a layer symboles
+	atomic_long			next; //prochain morceau de la couche
+}					t_tb_work;
+
+typedef struct
+{
+	pthread_t		thread;
+	t_tb_work		*work;
+	long			count[4]; //positions de la couche par resultat
+}					t_tb_thread;
+
+static t_tablebase		g_tables[MAX_TB_SIZE + 1];
+static atomic_int		g_tb_loaded[MAX_TB_SIZE + 1];
+static pthread_mutex_t	g_tb_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+//1 si les cases de b contiennent une ligne gagnante
+static int	has_line(const t_winmasks *w, t_bitboard b)
+{
+	for (int i = 0; i < w->nb_lines; i++)
+		if ((b & w->lines[i]) == w->lines[i])
+			return (1);
+	return (0);
+}
+
+//coefficients binomiaux jusqu'a MAX_TB_CELLS, calcules une fois (generateur, ou sous g_tb_mutex)
+static long	g_binom[MAX_TB_CELLS + 1][MAX_TB_CELLS + 1];
+
+static void	tb_binomials(void)
+{
+	for (int n = 0; n <= MAX_TB_CELLS; n++)
+	{
+		g_binom[n][0] = 1;
+		for (int k = 1; k <= n; k++)
+			g_binom[n][k] = g_binom[n - 1][k - 1] + (k < n ? g_binom[n - 1][k] : 0);
+	}
+}
+
+//premier rang de chaque nombre de symboles k : floor(k/2) au joueur qui a le trait, le reste a l'adversaire
+//offset[cells + 1] est le nombre total de positions rangees
+static long	tb_offsets(int cells, long *offset)
+{
+	int	m;
+
+	offset[0] = 0;
+	for (int k = 0; k <= cells; k++)
+	{
+		m = k / 2;
+		offset[k + 1] = offset[k] + g_binom[cells][m] * g_binom[cells - m][k - m];
+	}
+	return (offset[cells + 1]);
+}
+
+//rang colex d'un ensemble de cases : somme des C(case, numero du symbole + 1)
+static long	tb_rank_set(uint32_t set)
+{
+	long	r;
+	int		j;
+
+	r = 0;
+	j = 0;
+	while (set)
+	{
+		r += g_binom[__builtin_ctz(set)][j + 1];
+		j++;
+		set &= set - 1;
+	}
+	return (r);
+}
+
+//hachage parfait d'une position au nombre de symboles possible : couche, puis cases du joueur qui a
+//le trait parmi toutes, puis cases de l'adversaire parmi celles qui restent
+static long	tb_rank(const long *offset, int cells, uint32_t mover, uint32_t opp)
+{
+	uint32_t	rest;
+	int			m;
+	int			o;
+	int			j;
+
+	m = __builtin_popcount(mover);
+	o = __builtin_popcount(opp);
+	rest = 0;
+	j = 0;
+	for (int c = 0; c < cells; c++)
+	{
+		if (mover & (1u << c))
+			continue ;
+		if (opp & (1u << c))
+			rest |= 1u << j;
+		j++;
+	}
+	return (offset[m + o] + tb_rank_set(mover) * g_binom[cells - m][o] + tb_rank_set(rest));
+}
+
+//valeur d'une position a partir de celles de la couche suivante (un symbole de plus)
+//chiffre 1 : symbole du joueur qui a le trait, 2 : symbole de l'adversaire
+static unsigned char	tb_solve(t_tb_work *w, const t_winmasks *wm, long index)
+{
+	t_bitboard		bits[2];
+	long			swapped;
+	long			rest;
+	int				digit;
+	int				best;
+	int				worst;
+	int				draw;
+	unsigned char	v;
+
+	bits[0] = 0;
+	bits[1] = 0;
+	swapped = 0;
+	rest = index;
+	for (int c = 0; c < w->size * w->size; c++)
+	{
+		digit = (int)(rest % 3);
+		rest /= 3;
+		if (digit)
+		{
+			bits[digit - 1] |= (t_bitboard)1 << c;
+			swapped += (3 - digit) * w->pow3[c]; //la meme position vue par l'adversaire
+		}
+	}
+	digit = __builtin_popcountll((uint64_t)bits[1]) - __builtin_popcountll((uint64_t)bits[0]);
+	if ((digit != 0 && digit != 1) || has_line(wm, bits[0])) //X ou O peut commencer
+		return (TB_VALUE(TB_ILLEGAL, 0));
+	if (has_line(wm, bits[1]))
+		return (TB_VALUE(TB_LOSS, 0));
+	if ((bits[0] | bits[1]) == wm->full)
+		return (TB_VALUE(TB_DRAW, 0));
+	best = 64;
+	worst = -1;
+	draw = -1;
+	for (int c = 0; c < w->size * w->size; c++)
+	{
+		if ((bits[0] | bits[1]) & ((t_bitboard)1 << c))
+			continue ;
+		v = w->values[swapped + 2 * w->pow3[c]]; //apres le coup, l'adversaire a le trait
+		if (TB_RESULT(v) == TB_LOSS && TB_DIST(v) < best)
+			best = TB_DIST(v);
+		else if (TB_RESULT(v) == TB_DRAW && TB_DIST(v) > draw)
+			draw = TB_DIST(v);
+		else if (TB_RESULT(v) == TB_WIN && TB_DIST(v) > worst)
+			worst = TB_DIST(v);
+	}
+	if (best < 64)
+		return (TB_VALUE(TB_WIN, best + 1)); //on gagne le plus vite possible
+	if (draw >= 0)
+		return (TB_VALUE(TB_DRAW, draw + 1));
+	return (TB_VALUE(TB_LOSS, worst + 1)); //on perd le plus tard possible
+}
+
+//thread d'une couche : les positions de la couche ne dependent que de la couche suivante,
+//deja calculee, donc les morceaux se traitent dans n'importe quel ordre
+static void	*tb_thread(void *arg)
+{
+	t_tb_thread			*t;
+	t_tb_work			*w;
+	const t_winmasks	*wm;
+	long				begin;
+	long				end;
+
+	t = (t_tb_thread *)arg;
+	w = t->work;
+	wm = get_winmasks(w->size);
+	while ((begin = atomic_fetch_add(&w->next, TB_CHUNK)) < w->nb)
+	{
+		end = begin + TB_CHUNK < w->nb ? begin + TB_CHUNK : w->nb;
+		for (long i = begin; i < end; i++)
+		{
+			if (w->stones[i] != w->layer)
+				continue ;
+			w->values[i] = tb_solve(w, wm, i);
+			t->count[TB_RESULT(w->values[i])]++;
+		}
+	}
+	return (NULL);
+}
+
+//valeurs des positions rangees, dans l'ordre de tb_rank
+static unsigned char	*tb_pack(t_tb_work *w, long *offset, long *nb_ranked)
+{
+	unsigned char	*packed;
+	uint32_t		bits[2];
+	int				cells;
+	long			rest;
+	int				digit;
+
+	cells = w->size * w->size;
+	tb_binomials();
+	*nb_ranked = tb_offsets(cells, offset);
+	packed = (unsigned char *)arena_alloc(w->arena, (size_t)*nb_ranked);
+	if (packed == NULL)
+	{
+		fprintf(stderr, "Not enough memory for the %dx%d tablebase\n", w->size, w->size);
+		exit(EXIT_FAILURE);
+	}
+	for (long i = 0; i < w->nb; i++)
+	{
+		bits[0] = 0;
+		bits[1] = 0;
+		rest = i;
+		for (int c = 0; c < cells; c++)
+		{
+			digit = (int)(rest % 3);
+			rest /= 3;
+			if (digit)
+				bits[digit - 1] |= 1u << c;
+		}
+		digit = __builtin_popcount(bits[1]) - __builtin_popcount(bits[0]);
+		if (digit == 0 || digit == 1) //les autres n'ont pas de rang (et sont toutes TB_ILLEGAL)
+			packed[tb_rank(offset, cells, bits[0], bits[1])] = w->values[i];
+	}
+	return (packed);
+}
+
+//analyse retrograde d'une taille : des plateaux pleins jusqu'au plateau vide, couche par couche
+static void	tb_generate(t_arena *arena, int size)
+{
+	t_tb_work		w;
+	t_tb_thread		*threads;
+	int				nb_threads;
+	long			count[4];
+	t_tablebase_header	h;
+	char			path[128];
+	char			tmp[160];
+	FILE			*fp;
+	long			offset[MAX_TB_CELLS + 2];
+	long			nb_ranked;
+	unsigned char	*packed;
+
+	memset(&w, 0, sizeof(w));
+	w.size = size;
+	w.pow3[0] = 1;
+	for (int c = 1; c <= size * size; c++)
+		w.pow3[c] = w.pow3[c - 1] * 3;
+	w.nb = w.pow3[size * size];
+	w.arena = arena;
+	w.values = (unsigned char *)arena_alloc(arena, (size_t)w.nb);
+	w.stones = (unsigned char *)arena_alloc(arena, (size_t)w.nb);
+	if (w.values == NULL || w.stones == NULL)
+	{
+		fprintf(stderr, "Not enough memory for the %dx%d tablebase\n", size, size);
+		exit(EXIT_FAILURE);
+	}
+	for (long i = 1; i < w.nb; i++)
+		w.stones[i] = w.stones[i / 3] + (i % 3 != 0);
+	nb_threads = default_nb_workers();
+	threads = (t_tb_thread *)arena_alloc(arena, sizeof(t_tb_thread) * nb_threads);
+	memset(threads, 0, sizeof(t_tb_thread) * nb_threads);
+	memset(count, 0, sizeof(count));
+	for (w.layer = size * size; w.layer >= 0; w.layer--)
+	{
+		atomic_store(&w.next, 0);
+		for (int i = 0; i < nb_threads; i++)
+		{
+			threads[i].work = &w;
+			pthread_create(&threads[i].thread, NULL, tb_thread, threads + i);
+		}
+		for (int i = 0; i < nb_threads; i++)
+			pthread_join(threads[i].thread, NULL); //la couche suivante a besoin de toute celle-ci
+	}
+	for (int i = 0; i < nb_threads; i++)
+		for (int r = 0; r < 4; r++)
+			count[r] += threads[i].count[r];
+	packed = tb_pack(&w, offset, &nb_ranked);
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, TB_MAGIC, sizeof(h.magic));
+	h.version = TB_VERSION;
+	h.size = (uint32_t)size;
+	h.nb_positions = (uint64_t)nb_ranked;
+	mkdir(BOOK_DIR, 0755);
+	snprintf(path, sizeof(path), "%s/tablebase_%d.tttb", BOOK_DIR, size);
+	snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+	fp = fopen(tmp, "wb");
+	if (fp == NULL || fwrite(&h, sizeof(h), 1, fp) != 1
+		|| fwrite(packed, 1, (size_t)nb_ranked, fp) != (size_t)nb_ranked)
+	{
+		fprintf(stderr, "Failed to write %s\n", tmp);
+		exit(EXIT_FAILURE);
+	}
+	if (fclose(fp) != 0) //ecriture differee qui echoue (disque plein) : la table serait tronquee
+	{
+		fprintf(stderr, "Failed to write %s\n", tmp);
+		unlink(tmp);
+		exit(EXIT_FAILURE);
+	}
+	adjust_file_ownership(tmp);
+	if (rename(tmp, path) != 0)
+	{
+		fprintf(stderr, "Failed to rename %s to %s\n", tmp, path);
+		unlink(tmp);
+		exit(EXIT_FAILURE);
+	}
+	printf("Tablebase %dx%d: %ld wins, %ld losses, %ld draws, empty board is a %s in %d, written to %s\n",
+		size, size, count[TB_WIN], count[TB_LOSS], count[TB_DRAW],
+		TB_RESULT(w.values[0]) == TB_WIN ? "win" : TB_RESULT(w.values[0]) == TB_LOSS
+		? "loss" : "draw", TB_DIST(w.values[0]), path);
+}
+
+//./tictactoe tablebase [3|4|all]
+int	tb_command(t_arena *arena, int argc, char **argv)
+{
+	int	first;
+	int	last;
+
+	first = 3;
+	last = MAX_TB_SIZE;
+	if (argc > 0 && strcmp(argv[0], "all") != 0)
+	{
+		first = atoi(argv[0]);
+		last = first;
+	}
+	if (first < 3 || first > MAX_TB_SIZE)
+	{
+		fprintf(stderr, "usage: tictactoe tablebase [3|4|all]\n");
+		return (EXIT_FAILURE);
+	}
+	for (int size = first; size <= last; size++)
+		tb_generate(arena, size);
+	return (EXIT_SUCCESS);
+}
+
+//projette la table d'une taille ; sans fichier valide elle reste vide
+static void	tb_load(t_tablebase *tb, int size)
+{
+	char						path[128];
+	int							fd;
+	struct stat					st;
+	const t_tablebase_header	*h;
+
+	snprintf(path, sizeof(path), "%s/tablebase_%d.tttb", BOOK_DIR, size);
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return ;
+	if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(t_tablebase_header))
+	{
+		tb->map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		if (tb->map == MAP_FAILED)
+			tb->map = NULL;
+		tb->len = (size_t)st.st_size;
+	}
+	close(fd);
+	if (tb->map == NULL)
+		return ;
+	h = (const t_tablebase_header *)tb->map;
+	tb_binomials();
+	if (memcmp(h->magic, TB_MAGIC, sizeof(h->magic)) != 0
+		|| h->version != TB_VERSION || h->size != (uint32_t)size
+		|| h->nb_positions != (uint64_t)tb_offsets(size * size, tb->offset) //tb_move lit tous les rangs
+		|| tb->len != sizeof(*h) + h->nb_positions)
+	{
+		fprintf(stderr, "Ignoring invalid tablebase %s\n", path);
+		munmap(tb->map, tb->len);
+		tb->map = NULL;
+		return ;
+	}
+	tb->values = (const unsigned char *)(h + 1);
+}
+
+//table d'une taille, projetee a la premiere demande ; NULL si il n'y en a pas
+const t_tablebase	*tb_get(int size)
+{
+	if (size > MAX_TB_SIZE)
+		return (NULL);
+	if (!atomic_load_explicit(&g_tb_loaded[size], memory_order_acquire))
+	{
+		pthread_mutex_lock(&g_tb_mutex);
+		if (!atomic_load(&g_tb_loaded[size]))
+		{
+			tb_load(&g_tables[size], size);
+			atomic_store_explicit(&g_tb_loaded[size], 1, memory_order_release);
+		}
+		pthread_mutex_unlock(&g_tb_mutex);
+	}
+	if (g_tables[size].values == NULL)
+		return (NULL);
+	return (&g_tables[size]);
+}
+
+//coup parfait de player : une lecture de la table par coup possible, -1 sans table
+//on gagne le plus vite possible, sinon on annule, sinon on perd le plus tard possible
+int	tb_move(t_board *board, int player)
+{
+	const t_tablebase	*tb;
+	uint32_t			mine;
+	uint32_t			theirs;
+	int					cells;
+	int					best;
+	int					best_score;
+	int					score;
+	unsigned char		v;
+
+	tb = tb_get(board->size);
+	if (tb == NULL)
+		return (-1);
+	cells = board->size * board->size;
+	mine = (uint32_t)board->bits[player];
+	theirs = (uint32_t)board->bits[player ^ 1];
+	if (__builtin_popcount(mine) - __builtin_popcount(theirs) != 0
+		&& __builtin_popcount(theirs) - __builtin_popcount(mine) != 1)
+		return (-1); //position que la table ne couvre pas
+	best = -1;
+	best_score = -1;
+	for (int c = 0; c < cells; c++)
+	{
+		if ((mine | theirs) & (1u << c))
+			continue ;
+		v = tb->values[tb_rank(tb->offset, cells, theirs, mine | (1u << c))]; //l'adversaire a le trait
+		if (TB_RESULT(v) == TB_LOSS)
+			score = 256 - TB_DIST(v); //un alignement immediat est une defaite en 0 pour l'adversaire
+		else if (TB_RESULT(v) == TB_DRAW)
+			score = 128;
+		else
+			score = TB_DIST(v);
+		if (score > best_score)
+		{
+			best_score = score;
+			best = c;
+		}
+	}
+	return (best);
+}
@@ -0,0 +1,698 @@
+#ifndef TICTACTOE_H
+# define TICTACTOE_H
+
+# include <pthread.h>
+# include <semaphore.h>
+# include <stdatomic.h>
+# include <stdint.h>
+# include <stddef.h>
+
+# define MAX_SIZE 9 //taille maximale du plateau
+# define MAX_CELLS (MAX_SIZE * MAX_SIZE)
+# define ARENA_ALIGNMENT 16 //alignement des allocations de l'arene (requis par les bitboards 128 bits)
+# define ARENA_CHUNK_SIZE (4 << 20) //taille d'un morceau d'arene, une allocation plus grande a le sien
+# define ARENA_HUGE_PAGE (2 << 20) //morceaux a partir desquels on demande des grandes pages
+# define PROF_SEM_WAIT 0 //phases mesurees avec TTT_PROFILE (make PROFILE=1)
+# define PROF_MUTEX_WAIT 1
+# define PROF_MOVE 2 //choix et pose du coup
+# define PROF_GAME_DONE 3
+# define PROF_LOG_PUSH 4 //partie mise dans la file du journal
+# define PROF_LOG_WRITE 5 //write du thread ecrivain
+# define PROF_NB_PHASES 6
+# define PROF_SUB_BUCKETS 16 //cases par puissance de 2 des histogrammes
+# define PROF_BUCKETS 1024
+# define TRACE_GAME_START PROF_NB_PHASES //evenements ponctuels du journal de bord (make TRACE=1)
+# define TRACE_SEM_POST (PROF_NB_PHASES + 1)
+# define TRACE_EVENTS 262144 //evenements gardes par thread, les suivants sont comptes et perdus
+# define TRACE_MAX_THREADS 256
+# define ARENA_SITES 64 //fonctions suivies par les statistiques de l'arene (make ARENA_STATS=1)
+# define MAX_LINES 180 //nombre de lignes gagnantes en 9*9 avec 4 a aligner (54 + 54 + 36 + 36)
+# define EXEC_TWO_THREADS 0 //un thread par IA, passage de main par semaphores
+# define EXEC_SINGLE_THREAD 1 //les deux IA jouent dans le thread du worker
+# define PLACE_OS 0 //placement des threads d'un worker : laisse au systeme
+# define PLACE_SAME_CORE 1 //tous sur le meme processeur logique
+# define PLACE_SIBLINGS 2 //hyperthreads freres d'un meme coeur
+# define PLACE_SEPARATE 3 //un coeur physique par thread
+# define SCHED_MAX_SMT 8 //processeurs logiques gardes par coeur
+# define WINBATCH_SCALAR 0 //versions de win_batch_impl
+# define WINBATCH_SSE2 1
+# define WINBATCH_AVX2 2
+# define NB_SYMMETRIES 8 //rotations et reflexions d'un plateau carre
+# define MAX_CELL_LINES 16 //une case appartient au plus a 4 directions * 4 positions dans l'alignement
+# define LOG_MAGIC "TTTLOG\0\0" //debut de chaque segment du journal binaire
+# define LOG_FOOTER_MAGIC "TIDX" //fin d'un segment ferme proprement
+# define LOG_EXTENSION ".tttlog"
+# define LOG_VERSION 1
+# define LOG_RECORD_HEADER 4 //taille, premier joueur, resultat, nombre de coups
+# define LOG_RECORD_MAX (LOG_RECORD_HEADER + MAX_CELLS)
+# define LOG_RESULT_TIE 2
+# define LOG_SEED_FLAG 0x80 //dans l'octet du premier joueur : partie rangee par sa seule graine
+# define LOG_SEED_RECORD (LOG_RECORD_HEADER + 2 + 8) //en-tete, niveau des deux IA, graine
+# define LOG_SEGMENT_RECORDS (1 << 20) //nombre de parties par segment avant rotation
+# define LOG_INDEX_STRIDE 256 //une entree d'index toutes les 256 parties
+# define LOG_BUFFER_SIZE (1 << 16)
+# define LOG_RING_SIZE 4096 //nombre de parties en attente d'ecriture (puissance de 2)
+# define BOOK_DIR "./book"
+# define BOOK_MAGIC "TTTBOOK\0" //debut d'un livre d'ouvertures
+# define BOOK_VERSION 1
+# define BOOK_MAX_DEPTH 16 //nombre maximal de coups couverts par un livre
+# define TB_MAGIC "TTTTB\0\0\0" //debut d'une table de finales
+# define TB_VERSION 3 //un octet par position rangee : resultat et distance
+# define MAX_TB_SIZE 4 //tables completes en 3*3 et 4*4 (3^16 positions)
+# define MAX_TB_CELLS (MAX_TB_SIZE * MAX_TB_SIZE)
+# define TB_CHUNK 65536 //positions prises d'un coup par un thread du generateur
+# define AI_LEVEL_RANDOM 0 //coups aleatoires (tourOrdinateur)
+# define AI_LEVEL_EASY 1
+# define AI_LEVEL_MEDIUM 2
+# define AI_LEVEL_HARD 3
+# define AI_LEVEL_MCTS 4 //recherche Monte Carlo, pour les grands plateaux
+# define TT_BUCKET 4 //entrees par seau : un seau occupe une ligne de cache de 64 octets
+# define TT_DEFAULT_MB 16 //taille par defaut de la table de transposition partagee
+
+//un bitboard contient une case par bit : la case (l, c) est le bit l * size + c
+typedef unsigned __int128	t_bitboard;
+
+//morceau de memoire de l'arene, suivi de ses size octets utiles
+typedef struct s_arena_chunk
+{
+	struct s_arena_chunk	*prev; //morceau rempli avant celui-ci (ou morceau de cote suivant)
+	size_t					size;
+	size_t					dirty; //octets deja donnes une fois : au-dela, la memoire est encore a zero
+	size_t					pad; //garde les donnees alignees sur 16 octets
+}					t_arena_chunk;
+
+//allocations faites depuis une fonction
+typedef struct
+{
+	const char		*name; //__func__ de l'appelant
+	size_t			count;
+	size_t			bytes;
+}					t_arena_site;
+
+//statistiques de l'arene, tenues seulement si on compile avec ARENA_STATS
+typedef struct
+{
+	size_t			count; //nombre d'allocations
+	size_t			bytes; //octets demandes
+	size_t			padding; //octets perdus pour l'alignement
+	size_t			used; //octets pris en ce moment (rendus par arena_release)
+	size_t			high_water; //maximum de used
+	size_t			mapped; //octets des morceaux reserves
+	int				nb_chunks;
+	int				nb_sites;
+	t_arena_site	sites[ARENA_SITES];
+}					t_arena_stats;
+
+//structure d'allocation custom ( par pool de mémoire )
+typedef struct s_arena //Partie de la mémoire que l'on va allouer pour le code (pool de mémoire)
+{
+	void			*buf; //Adresse vers la plage de mémoire qui va être allouée (morceau courant)
+	size_t			buf_size; //taille de cette plage
+	size_t			prev_offset; //permet de réallouer pour le malloc (si on alloue un tableau de 100 octets, l'offset devient 100 et le nouvel espace mémoire que l'on va allouer sera buf+100)
+	size_t			curr_offset; //permet de réallouer pour le malloc
+	t_arena_chunk	*chunk; //morceau courant, chaine vers les precedents
+	t_arena_chunk	*spare; //morceaux rendus par arena_release, repris avant tout malloc
+	size_t			chunk_size;
+	t_arena_stats	stats;
+}					t_arena;
+
+//position de l'arene : tout ce qui est alloue apres se rend d'un coup
+typedef struct
+{
+	t_arena_chunk	*chunk;
+	size_t			offset;
+	size_t			used; //pour les statistiques
+}					t_arena_mark;
+
+typedef struct s_winmasks	t_winmasks;
+
+//histogramme de durees a echelle log-lineaire (facon HDR)
+typedef struct
+{
+	uint64_t		count;
+	uint64_t		total;
+	uint64_t		max;
+	uint64_t		buckets[PROF_BUCKETS];
+}					t_prof_hist;
+
+//histogrammes d'un thread, un par phase : chaque thread ecrit les siens sans verrou
+typedef struct
+{
+	t_prof_hist		hist[PROF_NB_PHASES];
+}					t_prof;
+
+//evenement du journal de bord : phase mesuree (dur > 0) ou evenement ponctuel
+typedef struct
+{
+	uint64_t		ts; //ns depuis le debut du lot
+	uint64_t		dur;
+	uint32_t		arg; //numero de la partie pour TRACE_GAME_START
+	uint32_t		phase;
+}					t_trace_event;
+
+//journal de bord d'un thread, ecrit sans verrou et vide en JSON a la fin du lot
+typedef struct
+{
+	t_trace_event	*events;
+	size_t			count;
+	uint64_t		dropped;
+	int				tid;
+	char			name[32];
+}					t_trace;
+
+//generateur pseudo-aleatoire xoshiro256** : chaque thread a le sien
+typedef struct
+{
+	uint64_t		s[4];
+}					t_rng;
+
+//structure du plateau de jeu
+typedef struct
+{
+	const t_winmasks	*masks; //lignes gagnantes de la taille du plateau
+	t_bitboard		bits[2]; //un masque par joueur : bits[0] pour X, bits[1] pour O
+	int				size; //taille du tableau
+	int				empty; //nombre de cases libres, pour le match nul en O(1)
+	int				last_move; //derniere case jouee (-1 si aucune)
+	int				winner; //joueur qui a aligne (0 pour X, 1 pour O, -1 sinon)
+	uint64_t		hash[NB_SYMMETRIES]; //cle Zobrist de la position vue par chaque symetrie
+	unsigned char	moves[MAX_CELLS]; //cases jouees dans l'ordre (size * size - empty coups)
+	unsigned char	free_cells[MAX_CELLS]; //les empty cases libres, dans le desordre
+	unsigned char	free_pos[MAX_CELLS]; //place de chaque case libre dans free_cells
+	unsigned char	line_count[2][MAX_LINES]; //nombre de symboles de chaque joueur sur chaque ligne gagnante
+}					t_board;
+
+//table des lignes gagnantes pour une taille de plateau
+struct s_winmasks
+{
+	t_bitboard		lines[MAX_LINES]; //masque de chaque alignement gagnant
+	t_bitboard		full; //masque de toutes les cases du plateau
+	int				nb_lines;
+	int				sequence; //nombre de symboles a aligner pour gagner : 3 en 3*3, 4 sinon
+	unsigned char	cell_lines[MAX_CELLS][MAX_CELL_LINES]; //indices des lignes qui passent par chaque case
+	unsigned char	cell_nb_lines[MAX_CELLS];
+	unsigned char	sym[NB_SYMMETRIES][MAX_CELLS]; //image de chaque case par chaque symetrie
+};
+
+//lot de plateaux de meme taille en structure de tableaux, un bitboard coupe en deux moities de 64 bits
+typedef struct
+{
+	const uint64_t	*lo; //pierres du joueur a verifier, cases 0 a 63
+	const uint64_t	*hi; //cases 64 a 80
+	const uint64_t	*occ_lo; //cases occupees par les deux joueurs
+	const uint64_t	*occ_hi;
+	int				nb;
+}					t_board_soa;
+
+//en-tete d'un segment du journal binaire (ordre des octets de la machine)
+typedef struct
+{
+	char			magic[8];
+	uint32_t		version;
+	uint32_t		header_size;
+}					t_log_header;
+
+//pied de page d'un segment : precede des nb_index offsets (uint64_t) d'une partie sur LOG_INDEX_STRIDE
+typedef struct
+{
+	uint32_t		nb_records;
+	uint32_t		nb_index;
+	uint32_t		stride;
+	char			magic[4];
+}					t_log_footer;
+
+//ecrivain du journal binaire : un fichier ouvert a la fois, ecrit par gros blocs
+typedef struct
+{
+	int				fd;
+	int				writer_id;
+	int				seq; //numero du prochain segment
+	long			stamp; //date d'ouverture, pour des noms de segments uniques
+	uint64_t		offset; //position de la fin du segment courant
+	uint32_t		nb_records; //nombre de parties dans le segment courant
+	size_t			buf_len;
+	char			path[128];
+	uint64_t		index[LOG_SEGMENT_RECORDS / LOG_INDEX_STRIDE];
+	unsigned char	buf[LOG_BUFFER_SIZE];
+}					t_gamelog;
+
+//partie lue dans le journal
+typedef struct
+{
+	int					size;
+	int					first_player; //0 ou 1 : joueur qui a joue le premier coup
+	int					result; //0 ou 1 : joueur gagnant, LOG_RESULT_TIE : nul
+	int					nb_moves;
+	const unsigned char	*moves; //cases jouees, en alternant a partir de first_player
+	uint64_t			seed; //graine de la partie si elle a ete rangee sans ses coups
+	int					seeded;
+	unsigned char		replay[MAX_CELLS]; //coups rejoues a partir de la graine
+}					t_log_record;
+
+//ce qu'il faut pour rejouer une partie : sa graine et le niveau des deux IA
+typedef struct
+{
+	uint64_t		seed;
+	unsigned char	levels[2];
+}					t_log_seed;
+
+//case de la file des parties a ecrire : seq dit a qui elle appartient (producteur ou ecrivain)
+typedef struct
+{
+	atomic_size_t	seq;
+	unsigned char	len;
+	unsigned char	rec[LOG_RECORD_MAX];
+}					t_log_slot;
+
+//file bornee sans verrou : plusieurs threads de jeu ajoutent, un seul thread ecrit sur le disque
+typedef struct
+{
+	_Alignas(64) atomic_size_t	tail; //prochaine case a prendre par un producteur
+	_Alignas(64) size_t			head; //prochaine case a lire par le thread ecrivain
+	_Alignas(64) atomic_ulong	dropped; //parties jetees quand la file est pleine
+	atomic_int		stop; //demande d'arret au thread ecrivain
+	int				block; //1 : le producteur attend de la place, 0 : il jette la partie
+	t_log_slot		*slots;
+	t_gamelog		*log;
+	pthread_t		thread;
+# ifdef TTT_PROFILE
+	t_prof			prof; //thread ecrivain
+# endif
+# ifdef TTT_TRACE
+	t_trace			trace;
+# endif
+}					t_logring;
+
+//entree de la table de transposition, telle que la recherche la lit et l'ecrit
+typedef struct
+{
+	int32_t			score;
+	signed char		depth; //profondeur restante de la recherche qui a donne score
+	unsigned char	flag; //score exact, borne basse ou borne haute
+	unsigned char	move; //meilleur coup trouve, essaye en premier la fois suivante
+}					t_tt_entry;
+
+//case de la table : check vaut cle ^ data, ce qui detecte une case a moitie ecrite sans verrou
+typedef struct
+{
+	_Atomic uint64_t	check;
+	_Atomic uint64_t	data; //score, profondeur, type de borne, coup, age
+}					t_tt_slot;
+
+typedef struct
+{
+	_Alignas(64) t_tt_slot	slot[TT_BUCKET];
+}					t_tt_bucket;
+
+//compteurs d'un thread, ajoutes a ceux de la table a la fin de chaque coup
+typedef struct
+{
+	long			hits;
+	long			misses;
+	long			collisions; //une position en a chasse une autre
+}					t_tt_stats;
+
+//table de transposition partagee par toutes les recherches d'un lot, sans verrou
+typedef struct
+{
+	t_tt_bucket		*buckets;
+	size_t			mask; //nombre de seaux - 1
+	atomic_int		generation; //age courant, augmente a chaque recherche
+	atomic_long		hits;
+	atomic_long		misses;
+	atomic_long		collisions;
+}					t_tt;
+
+//moteur d'une IA : negamax alpha-beta avec approfondissement iteratif et table de transposition
+typedef struct
+{
+	int				max_depth;
+	long			max_nodes; //budget de positions par coup
+	long			nodes;
+	int				stop; //budget epuise : l'iteration en cours est abandonnee
+	int				score; //valeur du dernier coup choisi pour le joueur qui l'a joue
+	int				size; //taille pour laquelle order et near ont ete calcules
+	unsigned char	order[MAX_CELLS]; //cases du centre vers les bords
+	t_bitboard		near[MAX_CELLS]; //cases voisines de chaque case
+	t_tt			*tt; //table partagee avec les autres recherches
+	t_tt_stats		stats;
+	t_rng			rng; //melange des coups a la racine
+}					t_search;
+
+//noeud de l'arbre Monte Carlo, mis a jour sans verrou par tous les threads de la recherche
+typedef struct
+{
+	atomic_int		visits; //compte aussi les descentes en cours (perte virtuelle)
+	atomic_int		score; //2 par victoire, 1 par nul, du point de vue du joueur qui a joue move
+	atomic_int		state; //MCTS_* : pas encore developpe, en cours, developpe ou feuille
+	int				first_child; //indice du premier fils dans la reserve de noeuds
+	unsigned char	nb_children;
+	unsigned char	move; //case jouee pour arriver dans ce noeud
+}					t_mcts_node;
+
+typedef struct s_mcts	t_mcts;
+
+//thread de la recherche Monte Carlo, avec son plateau de travail pour les parties aleatoires
+typedef struct
+{
+	pthread_t		thread;
+	t_mcts			*mcts;
+	t_rng			rng;
+	t_board			board;
+}					t_mcts_thread;
+
+//moteur Monte Carlo (UCT) : plusieurs threads developpent le meme arbre
+struct s_mcts
+{
+	int				nb_threads;
+	long			max_playouts; //budget de parties aleatoires par coup (0 : budget en temps)
+	long			max_ms; //budget en millisecondes par coup
+	t_mcts_node		*nodes; //reserve de noeuds, allouee une fois dans l'arene
+	int				max_nodes;
+	atomic_int		nb_nodes;
+	atomic_long		playouts;
+	double			deadline;
+	const t_board	*root; //position a jouer
+	int				player; //joueur qui a le trait a la racine
+	t_mcts_thread	*threads;
+	pthread_mutex_t	lock; //les threads auxiliaires attendent ici entre deux coups
+	pthread_cond_t	start; //un nouveau coup a chercher (ou l'arret)
+	pthread_cond_t	done; //le dernier thread auxiliaire a fini sa recherche
+	unsigned long	generation; //numero du coup en cours
+	int				running; //threads auxiliaires encore dans la recherche du coup
+	int				stop;
+};
+
+//reglages d'une IA choisis par l'utilisateur
+typedef struct
+{
+	int				level; //AI_LEVEL_*
+	int				nb_threads; //threads de la recherche Monte Carlo
+	long			playouts; //parties aleatoires par coup (0 : budget en temps)
+	long			time_ms;
+	long			tt_mb; //taille de la table de transposition partagee
+}					t_ai_config;
+
+//en-tete d'un livre d'ouvertures ./book/book_<taille>.tttbook, suivi des entrees triees par cle
+typedef struct
+{
+	char			magic[8];
+	uint32_t		version;
+	uint32_t		size;
+	uint32_t		depth; //les positions des depth premiers coups sont couvertes
+	uint32_t		source; //0 : recherche, 1 : historique des parties
+	uint64_t		nb_entries;
+}					t_book_header;
+
+//coup du livre pour une position ; la cle et le coup sont dans le repere canonique
+typedef struct
+{
+	uint64_t		key; //search_key de la position
+	int32_t			score; //valeur du coup pour le joueur qui a le trait
+	unsigned char	move;
+	unsigned char	pad[3];
+}					t_book_entry;
+
+//livre projete en memoire : on y cherche directement, sans rien lire au demarrage
+typedef struct
+{
+	void				*map;
+	size_t				len;
+	const t_book_entry	*entries;
+	long				nb_entries;
+}					t_book;
+
+//en-tete d'une table ./book/tablebase_<taille>.tttb, suivi d'un octet par position (2 bits de
+//resultat, 6 de distance) : seules les positions au nombre de symboles possible ont un rang (tb_rank),
+//le joueur qui a le trait a autant de symboles que l'adversaire ou un de moins
+typedef struct
+{
+	char			magic[8];
+	uint32_t		version;
+	uint32_t		size;
+	uint64_t		nb_positions;
+}					t_tablebase_header;
+
+//table projetee en memoire
+typedef struct
+{
+	void				*map;
+	size_t				len;
+	const unsigned char	*values; //resultat et distance, un octet par position
+	long				offset[MAX_TB_CELLS + 2]; //premier rang de chaque nombre de symboles
+}					t_tablebase;
+
+//reglages d'un lot de parties IA contre IA (menu ou ./tictactoe bench)
+typedef struct
+{
+	int				size;
+	int				nb_games;
+	int				nb_workers;
+	int				policy; //-1 : politique du systeme, sinon SCHED_FIFO ou SCHED_RR
+	int				priority; //priorite dans la politique, 0 : la plus haute
+	int				placement; //PLACE_OS, PLACE_SAME_CORE, PLACE_SIBLINGS ou PLACE_SEPARATE
+	int				latency; //1 : on mesure la duree de chaque partie
+	int				exec_mode; //EXEC_TWO_THREADS ou EXEC_SINGLE_THREAD
+	int				block; //file du journal pleine : 1 on attend, 0 on jette
+	int				io; //0 : les parties ne sont pas ecrites
+	int				seed_only;
+	uint64_t		seed; //graine maitresse
+	t_ai_config		ais[2];
+}					t_batch;
+
+//mesures d'un lot
+typedef struct
+{
+	int				results[3]; //victoires de l'IA 1, de l'IA 2, nuls
+	long			moves;
+	long			tb_moves; //coups lus dans la table de finales (0 sans fichier ./book/tablebase_N.tttb)
+	long			book_moves; //coups lus dans le livre d'ouvertures
+	double			wall; //secondes, horloge monotone
+	double			cpu; //secondes de processeur de tous les threads
+	unsigned long	dropped; //parties jetees par la file du journal
+	int				has_tt;
+	long			tt_hits;
+	long			tt_misses;
+	long			tt_collisions;
+	int				sched_errors; //threads dont la politique ou le placement a ete refuse
+	int				has_latency;
+	uint64_t		latency_p50; //duree d'une partie en ns
+	uint64_t		latency_p99;
+}					t_batch_result;
+
+//file de parties partagee par les workers de l'IA contre IA
+typedef struct
+{
+	int				nb_games; //nombre total de parties du lot
+	atomic_int		next_game; //indice de la prochaine partie a distribuer
+	uintptr_t		base_id; //identifiant de la premiere partie (nom des fichiers d'historique)
+	uint64_t		seed; //graine maitresse : la graine de chaque partie en derive
+	int				seed_only; //1 : on ne range que la graine de chaque partie
+	unsigned char	levels[2]; //niveau des deux IA
+	atomic_int		sched_errors; //reglages d'ordonnancement refuses par le systeme
+}					t_pool;
+
+//structure du jeu
+typedef struct //contient tous les elements necessaires pour nous permettre de jouer
+{
+	t_board			*board;//pointeur vers la structure qui contient le tableau
+	int				player_turn; //definit qui doit jouer
+	int				game_type; //définit le type de partie que l'on veut jouer
+	pthread_mutex_t	*mutex; //Ce qui permet de bloquer un thread, evite que les deux threads accèdent au même espace memoire
+	sem_t			*sem; //Permet de donner un ordre d execution dans les threads
+	pthread_t		thread[2]; //cree un tableau qui contient les adresses des 2 threads
+	t_arena			*arena;
+	int				done;
+	int				player1;
+	int				policy; //politique d ordonnancement
+	int				priority; //0 : la plus haute de la politique
+	int				cpu[2]; //processeur de chaque thread d'IA, -1 : au choix du systeme
+	t_prof_hist		*latency; //duree des parties du worker, NULL si on ne la mesure pas
+	uint64_t		started; //debut de la partie en cours (ns), avec latency
+	uintptr_t		id; //identifiant de la partie, sert a nommer le fichier d'historique
+	t_pool			*pool; //file de parties du worker (IA contre IA)
+	int				results[3]; //victoires de l'IA 1, de l'IA 2 et nuls du worker
+	long			moves; //nombre de coups joues par le worker
+	int				use_tables[2]; //1 : l'IA lit la table de finales et le livre (niveaux difficile et MCTS)
+	long			tb_moves; //coups joues depuis la table de finales
+	long			book_moves; //coups joues depuis le livre d'ouvertures
+	int				exec_mode; //EXEC_TWO_THREADS ou EXEC_SINGLE_THREAD
+	int				first_player; //joueur qui a commence la partie
+	t_gamelog		*log; //journal ou la partie est ecrite a la fin
+	t_logring		*ring; //file vers le thread ecrivain (IA contre IA), prioritaire sur log
+	t_search		*search[2]; //moteur de chaque IA, NULL pour le jeu aleatoire
+	t_mcts			*mcts[2]; //moteur Monte Carlo de chaque IA, NULL si elle n'en a pas
+	t_rng			rng; //generateur des coups aleatoires de la partie en cours
+	uint64_t		seed; //graine de la partie en cours
+# ifdef TTT_PROFILE
+	t_prof			prof[2]; //un par thread d'IA (prof[0] en mode un seul thread)
+# endif
+# ifdef TTT_TRACE
+	t_trace			trace[2];
+# endif
+}					t_game;
+
+//structure d'analyse des parties
+typedef struct
+{
+	int				**win_by_first_move; //on stocke les first move qui permettent de gagner dans un tableau pour les compter ([taille][case])
+	int				**win_by_second_move; //on stocke les second move qui permettent de gagner dans un tableau pour les compter
+	int				win_by_first_player;
+	int				win_by_second_player;
+	int				tie;
+	int				nb_games;
+	int				bad_records; //fichiers ou blocs de parties illisibles, sautes
+
+}					t_analyse;
+
+# define HLINE_OTHER 0
+# define HLINE_SIZE 1 //size:N (taille dans x)
+# define HLINE_MOVE 2 //Player N: (l, c)
+# define HLINE_WIN 3 //Player N wins
+# define HLINE_TIE 4
+
+//ligne reconnue d'un fichier d'historique texte
+typedef struct
+{
+	int				type;
+	char			player; //'1' ou '2'
+	int				x;
+	int				y;
+}					t_history_line;
+
+//avec ARENA_STATS chaque allocation est comptee au nom de la fonction qui la demande
+# ifdef ARENA_STATS
+#  define arena_alloc(a, size) arena_alloc_site(a, size, __func__)
+# else
+#  define arena_alloc(a, size) arena_alloc_site(a, size, NULL)
+# endif
+
+//mesure d'une phase : PROF_BEGIN(t) ... PROF_END(PROF_MOVE, t), rien sans TTT_PROFILE ni TTT_TRACE
+# if defined(TTT_PROFILE) || defined(TTT_TRACE)
+#  define PROF_BEGIN(t) uint64_t t = prof_now()
+#  define PROF_END(phase, t) prof_record(phase, t)
+# else
+#  define PROF_BEGIN(t) do {} while (0)
+#  define PROF_END(phase, t) do {} while (0)
+# endif
+# ifdef TTT_TRACE
+#  define TRACE_INSTANT(phase, arg) trace_instant(phase, arg)
+# else
+#  define TRACE_INSTANT(phase, arg) do {} while (0)
+# endif
+
+//declaration des prototypes
+
+void				*arena_init(size_t chunk_size);
+void				arena_reset(t_arena *a);
+t_arena_mark		arena_mark(t_arena *a);
+void				arena_release(t_arena *a, t_arena_mark mark);
+void				*arena_alloc_site(t_arena *a, size_t size, const char *site);
+void				arena_destroy(t_arena *a);
+void				set_game_mode(t_arena *a, t_game *game);
+void				set_boardsize(t_arena *arena, t_board *board);
+void				print_board(t_board *board);
+void				init_board(t_board *board);
+const t_winmasks	*get_winmasks(int size);
+char				board_get(t_board *board, int ligne, int colonne);
+void				board_set(t_board *board, int ligne, int colonne,
+						char symbole);
+int					board_play(t_board *board, int cell, int player);
+void				board_undo(t_board *board, int cell, int player);
+int					board_random_cell(t_board *board, t_rng *rng);
+uint64_t			splitmix64(uint64_t *state);
+void				rng_seed(t_rng *rng, uint64_t seed);
+uint64_t			rng_derive(uint64_t master, uint64_t index);
+uint64_t			rng_next(t_rng *rng);
+unsigned int		rng_below(t_rng *rng, unsigned int n);
+int					sym_cell(int size, int s, int l, int c);
+int					sym_inverse(int s);
+uint64_t			board_canonical_key(t_board *board, int *sym);
+int					sym_canonical_cell(int size, int cell);
+void				is_game_done(t_arena *arena, t_board *board, t_game *game);
+int					verifierMatchNul(t_board *board);
+int					verifierGagnantDynamic(t_board *board, char symbole);
+int					win_batch_best(void);
+void				win_batch_impl(int impl, const t_winmasks *w,
+						const t_board_soa *soa, uint64_t *wins, uint64_t *ties);
+void				win_batch(const t_winmasks *w, const t_board_soa *soa,
+						uint64_t *wins, uint64_t *ties);
+void				play_one_turn(t_arena *arena, t_board *board, t_game *game);
+void				tourOrdinateur(t_board *board, t_game *game);
+void				init_game(t_arena *arena, t_game *game);
+void				*thread_IA1(void *arg);
+void				*thread_IA2(void *arg);
+void				*thread_IA_single(void *arg);
+uint64_t			prof_now(void);
+void				prof_attach(t_prof *p);
+void				prof_record(int phase, uint64_t start);
+void				prof_merge(t_prof *dst, const t_prof *src);
+void				prof_hist_add(t_prof_hist *h, uint64_t ns);
+void				prof_hist_merge(t_prof_hist *dst, const t_prof_hist *src);
+uint64_t			prof_percentile(const t_prof_hist *h, int q);
+void				prof_report(const t_prof *p);
+const char			*prof_phase_name(int phase);
+void				trace_begin(void);
+void				trace_init(t_arena *arena, t_trace *t, const char *name);
+void				trace_attach(t_trace *t);
+void				trace_record(int phase, uint64_t start, uint64_t dur);
+void				trace_instant(int phase, uint32_t arg);
+void				trace_write(void);
+void				run_ai_batch(t_arena *arena, const t_batch *b, t_batch_result *r);
+int					bench_command(t_arena *arena, int argc, char **argv);
+void				tt_init(t_arena *arena, t_tt *tt, long mb);
+void				tt_new_search(t_tt *tt);
+int					tt_probe(t_tt *tt, uint64_t key, t_tt_entry *e,
+						t_tt_stats *stats);
+void				tt_store(t_tt *tt, uint64_t key, const t_tt_entry *e,
+						t_tt_stats *stats);
+void				tt_flush_stats(t_tt *tt, t_tt_stats *stats);
+void				search_init(t_search *s, int level, t_tt *tt, uint64_t seed);
+int					search_best_move(t_search *s, t_board *board, int player);
+uint64_t			search_key(t_board *board, int player, int *sym);
+const t_book		*book_get(int size);
+int					book_move(t_board *board, int player);
+int					book_command(t_arena *arena, int argc, char **argv);
+const t_tablebase	*tb_get(int size);
+int					tb_move(t_board *board, int player);
+int					tb_command(t_arena *arena, int argc, char **argv);
+void				mcts_init(t_arena *arena, t_mcts *m, const t_ai_config *ai,
+						uint64_t seed);
+int					mcts_best_move(t_mcts *m, t_board *board, int player);
+void				mcts_free(t_mcts *m);
+int					set_thread_policy_and_priority(pthread_t thread, int policy,
+						int priority);
+int					set_thread_affinity(pthread_t thread, int cpu);
+int					sched_probe(int policy, int priority);
+int					sched_place_cpu(int placement, int worker, int player,
+						int per_worker);
+int					default_nb_workers(void);
+const char			*parse_history_line(const char *p, const char *end,
+						t_history_line *line);
+void				init_analyse(t_arena *arena, t_analyse *analyse);
+void				merge_analyse(t_analyse *dst, const t_analyse *src);
+void				analyse_history(t_arena *arena, const char *path, int fold);
+void				adjust_file_ownership(const char *filename);
+void				gamelog_open(t_gamelog *log);
+size_t				gamelog_encode_seed(t_board *board, int first_player, int result,
+						const t_log_seed *seed, unsigned char *rec);
+size_t				gamelog_encode(t_board *board, int first_player, int result,
+						unsigned char *rec);
+void				gamelog_append_raw(t_gamelog *log, const unsigned char *rec,
+						size_t len);
+void				gamelog_append(t_gamelog *log, t_board *board,
+						int first_player, int result);
+void				gamelog_sync(t_gamelog *log);
+void				logring_start(t_arena *arena, t_logring *ring, int block);
+int					logring_push(t_logring *ring, t_board *board,
+						int first_player, int result, const t_log_seed *seed);
+void				logring_stop(t_logring *ring);
+void				gamelog_close(t_gamelog *log);
+size_t				gamelog_parse(const unsigned char *p, size_t len,
+						t_log_record *rec);
+long				gamelog_records(const unsigned char *buf, size_t len,
+						const unsigned char **begin, const unsigned char **end);
+int					gamelog_find(const unsigned char *buf, size_t len, long n,
+						t_log_record *rec);
+
+#endif
@@ -0,0 +1,125 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "tictactoe.h"
+
+static const char	*g_instants[] = {"game_start", "sem_post"};
+
+static t_trace	*g_traces[TRACE_MAX_THREADS]; //journaux de bord du lot, dans l'ordre des threads
+static int		g_nb_traces;
+static uint64_t	g_origin; //debut du lot : les dates du fichier en partent
+static int		g_batch; //numero du lot, pour le nom du fichier
+
+static _Thread_local t_trace	*g_trace; //journal du thread courant, NULL s'il n'est pas suivi
+
+//nouveau lot : les journaux du lot precedent sont oublies
+void	trace_begin(void)
+{
+	g_nb_traces = 0;
+	g_origin = prof_now();
+	g_batch++;
+}
+
+//prepare le journal d'un thread avant son lancement (appele par un seul thread)
+void	trace_init(t_arena *arena, t_trace *t, const char *name)
+{
+	t->events = (t_trace_event *)arena_alloc(arena, sizeof(t_trace_event) * TRACE_EVENTS);
+	if (t->events == NULL)
+	{
+		fprintf(stderr, "Not enough memory for the trace buffers\n");
+		exit(EXIT_FAILURE);
+	}
+	t->count = 0;
+	t->dropped = 0;
+	snprintf(t->name, sizeof(t->name), "%s", name);
+	if (g_nb_traces < TRACE_MAX_THREADS)
+		g_traces[g_nb_traces++] = t;
+	t->tid = g_nb_traces;
+}
+
+//le thread courant ecrit desormais ses evenements dans t, sans verrou
+void	trace_attach(t_trace *t)
+{
+	g_trace = t;
+}
+
+//ajoute un evenement au journal du thread courant ; plein, on compte ce qu'on perd
+static void	trace_push(int phase, uint64_t start, uint64_t dur, uint32_t arg)
+{
+	t_trace_event	*e;
+
+	if (g_trace == NULL)
+		return ;
+	if (g_trace->count == TRACE_EVENTS)
+	{
+		g_trace->dropped++;
+		return ;
+	}
+	e = &g_trace->events[g_trace->count++];
+	e->ts = start - g_origin;
+	e->dur = dur;
+	e->arg = arg;
+	e->phase = (uint32_t)phase;
+}
+
+//phase de start a start + dur
+void	trace_record(int phase, uint64_t start, uint64_t dur)
+{
+	trace_push(phase, start, dur, 0);
+}
+
+//evenement ponctuel (debut de partie, main passee a l'autre thread)
+void	trace_instant(int phase, uint32_t arg)
+{
+	trace_push(phase, prof_now(), 0, arg);
+}
+
+//un evenement au format Chrome : duree pour les phases, instantane sinon (dates en microsecondes)
+static void	trace_print_event(FILE *fp, const t_trace *t, const t_trace_event *e, int pid)
+{
+	if (e->phase < PROF_NB_PHASES)
+		fprintf(fp, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+			prof_phase_name((int)e->phase), pid, t->tid, e->ts / 1000.0, e->dur / 1000.0);
+	else
+		fprintf(fp, ",\n{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"pid\":%d,\"tid\":%d,"
+			"\"ts\":%.3f,\"args\":{\"game\":%u}}", g_instants[e->phase - PROF_NB_PHASES],
+			pid, t->tid, e->ts / 1000.0, e->arg);
+}
+
+//ecrit les journaux du lot en JSON Chrome (chrome://tracing, Perfetto) dans ./trace_<lot>.json
+//a appeler une fois tous les threads du lot termines
+void	trace_write(void)
+{
+	FILE		*fp;
+	char		path[64];
+	int			pid;
+	size_t		nb_events;
+	uint64_t	dropped;
+
+	snprintf(path, sizeof(path), "./trace_%d.json", g_batch);
+	fp = fopen(path, "w");
+	if (fp == NULL)
+	{
+		fprintf(stderr, "Failed to open %s for writing\n", path);
+		exit(EXIT_FAILURE);
+	}
+	pid = (int)getpid();
+	nb_events = 0;
+	dropped = 0;
+	fprintf(fp, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n"
+		"{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"tictactoe\"}}", pid);
+	for (int i = 0; i < g_nb_traces; i++)
+	{
+		fprintf(fp, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+			"\"args\":{\"name\":\"%s\"}}", pid, g_traces[i]->tid, g_traces[i]->name);
+		for (size_t j = 0; j < g_traces[i]->count; j++)
+			trace_print_event(fp, g_traces[i], g_traces[i]->events + j, pid);
+		nb_events += g_traces[i]->count;
+		dropped += g_traces[i]->dropped;
+	}
+	fprintf(fp, "\n]}\n");
+	fclose(fp);
+	fprintf(stderr, "Trace: %zu events written to %s, %lu lost to full buffers\n",
+		nb_events, path, (unsigned long)dropped);
+}
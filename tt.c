@@ -0,0 +1,134 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "tictactoe.h"
+
+//rangement d'une entree dans le mot data d'une case
+#define TT_SCORE_MASK 0xFFFFFFFFULL
+#define TT_DEPTH_SHIFT 32
+#define TT_FLAG_SHIFT 40
+#define TT_MOVE_SHIFT 42
+#define TT_AGE_SHIFT 50
+#define TT_AGE_MASK 63
+#define TT_VALID (1ULL << 56) //une case a zero est vide
+
+static int	tt_age(uint64_t data)
+{
+	return ((int)((data >> TT_AGE_SHIFT) & TT_AGE_MASK));
+}
+
+//prepare une table de mb megaoctets (arrondie a une puissance de 2 de seaux), prise une fois dans l'arene
+void	tt_init(t_arena *arena, t_tt *tt, long mb)
+{
+	size_t		nb;
+	uintptr_t	p;
+
+	if (mb < 1)
+		mb = TT_DEFAULT_MB;
+	nb = 1;
+	while (nb * 2 * sizeof(t_tt_bucket) <= (size_t)mb << 20)
+		nb *= 2;
+	p = (uintptr_t)arena_alloc(arena, nb * sizeof(t_tt_bucket) + 64);
+	if (p == 0)
+	{
+		fprintf(stderr, "Not enough memory for the transposition table\n");
+		exit(EXIT_FAILURE);
+	}
+	tt->buckets = (t_tt_bucket *)((p + 63) & ~(uintptr_t)63); //un seau par ligne de cache
+	tt->mask = nb - 1;
+	atomic_init(&tt->generation, 0);
+	atomic_init(&tt->hits, 0);
+	atomic_init(&tt->misses, 0);
+	atomic_init(&tt->collisions, 0);
+}
+
+//nouvelle recherche : les entrees des recherches precedentes vieillissent
+void	tt_new_search(t_tt *tt)
+{
+	atomic_fetch_add_explicit(&tt->generation, 1, memory_order_relaxed);
+}
+
+//cherche une position ; une case n'est acceptee que si check ^ data redonne la cle,
+//ce qui ecarte sans verrou les cases a moitie ecrites par un autre thread
+int	tt_probe(t_tt *tt, uint64_t key, t_tt_entry *e, t_tt_stats *stats)
+{
+	t_tt_slot	*slot;
+	uint64_t	data;
+
+	slot = tt->buckets[key & tt->mask].slot;
+	for (int i = 0; i < TT_BUCKET; i++)
+	{
+		data = atomic_load_explicit(&slot[i].data, memory_order_relaxed);
+		if ((data & TT_VALID)
+			&& (atomic_load_explicit(&slot[i].check, memory_order_relaxed) ^ data) == key)
+		{
+			e->score = (int32_t)(uint32_t)(data & TT_SCORE_MASK);
+			e->depth = (signed char)(data >> TT_DEPTH_SHIFT);
+			e->flag = (unsigned char)((data >> TT_FLAG_SHIFT) & 3);
+			e->move = (unsigned char)(data >> TT_MOVE_SHIFT);
+			stats->hits++;
+			return (1);
+		}
+	}
+	stats->misses++;
+	return (0);
+}
+
+//range une position : on remplace la meme position si la nouvelle recherche est au moins aussi
+//profonde, sinon la case vide ou celle qui vaut le moins (peu profonde et ancienne)
+void	tt_store(t_tt *tt, uint64_t key, const t_tt_entry *e, t_tt_stats *stats)
+{
+	t_tt_slot	*slot;
+	uint64_t	data;
+	int			gen;
+	int			value;
+	int			worst;
+	int			victim;
+
+	slot = tt->buckets[key & tt->mask].slot;
+	gen = atomic_load_explicit(&tt->generation, memory_order_relaxed) & TT_AGE_MASK;
+	victim = 0;
+	worst = 1 << 30;
+	for (int i = 0; i < TT_BUCKET; i++)
+	{
+		data = atomic_load_explicit(&slot[i].data, memory_order_relaxed);
+		if (!(data & TT_VALID))
+			value = -(1 << 30);
+		else if ((atomic_load_explicit(&slot[i].check, memory_order_relaxed) ^ data) == key)
+		{
+			if ((signed char)(data >> TT_DEPTH_SHIFT) > e->depth
+				&& tt_age(data) == gen)
+				return ; //une recherche plus profonde de cette position est deja la
+			victim = i;
+			break ;
+		}
+		else
+			value = (signed char)(data >> TT_DEPTH_SHIFT)
+				- 4 * ((gen - tt_age(data)) & TT_AGE_MASK);
+		if (value < worst)
+		{
+			worst = value;
+			victim = i;
+		}
+	}
+	data = atomic_load_explicit(&slot[victim].data, memory_order_relaxed);
+	if ((data & TT_VALID)
+		&& (atomic_load_explicit(&slot[victim].check, memory_order_relaxed) ^ data) != key)
+		stats->collisions++; //une autre position est chassee
+	data = (uint64_t)(uint32_t)e->score | (uint64_t)(unsigned char)e->depth << TT_DEPTH_SHIFT
+		| (uint64_t)(e->flag & 3) << TT_FLAG_SHIFT | (uint64_t)e->move << TT_MOVE_SHIFT
+		| (uint64_t)gen << TT_AGE_SHIFT | TT_VALID;
+	atomic_store_explicit(&slot[victim].data, data, memory_order_relaxed);
+	atomic_store_explicit(&slot[victim].check, key ^ data, memory_order_relaxed);
+}
+
+//ajoute aux compteurs de la table ceux d'un thread, puis les remet a zero
+void	tt_flush_stats(t_tt *tt, t_tt_stats *stats)
+{
+	atomic_fetch_add_explicit(&tt->hits, stats->hits, memory_order_relaxed);
+	atomic_fetch_add_explicit(&tt->misses, stats->misses, memory_order_relaxed);
+	atomic_fetch_add_explicit(&tt->collisions, stats->collisions, memory_order_relaxed);
+	stats->hits = 0;
+	stats->misses = 0;
+	stats->collisions = 0;
+}
@@ -0,0 +1,199 @@
+#include <stdint.h>
+#include <string.h>
+#if defined(__x86_64__) || defined(__i386__)
+# include <immintrin.h>
+#endif
+
+#include "tictactoe.h"
+
+//masques des lignes coupes en deux moities de 64 bits, comme les plateaux du lot
+typedef struct
+{
+	uint64_t	lo[MAX_LINES];
+	uint64_t	hi[MAX_LINES];
+	uint64_t	full_lo;
+	uint64_t	full_hi;
+	int			nb_lines;
+}				t_split_masks;
+
+static void	split_masks(const t_winmasks *w, t_split_masks *m)
+{
+	m->nb_lines = w->nb_lines;
+	for (int i = 0; i < w->nb_lines; i++)
+	{
+		m->lo[i] = (uint64_t)w->lines[i];
+		m->hi[i] = (uint64_t)(w->lines[i] >> 64);
+	}
+	m->full_lo = (uint64_t)w->full;
+	m->full_hi = (uint64_t)(w->full >> 64);
+}
+
+//plateaux de from a nb un par un : meme test que verifierGagnantDynamic et verifierMatchNul
+static void	batch_scalar(const t_split_masks *m, const t_board_soa *soa, int from,
+	uint64_t *wins, uint64_t *ties)
+{
+	uint64_t	bit;
+
+	for (int b = from; b < soa->nb; b++)
+	{
+		bit = (uint64_t)1 << (b & 63);
+		for (int i = 0; i < m->nb_lines; i++)
+		{
+			if ((soa->lo[b] & m->lo[i]) == m->lo[i] && (soa->hi[b] & m->hi[i]) == m->hi[i])
+			{
+				wins[b >> 6] |= bit;
+				break ;
+			}
+		}
+		if (soa->occ_lo[b] == m->full_lo && soa->occ_hi[b] == m->full_hi)
+			ties[b >> 6] |= bit;
+	}
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+//deux plateaux par registre : une ligne est complete quand aucune de ses cases ne manque (~b & masque == 0)
+//SSE2 n'a pas de comparaison sur 64 bits : on compare les deux moities de 32 bits et on les combine
+static __m128i	zero_lanes_sse2(__m128i v)
+{
+	__m128i	eq;
+
+	eq = _mm_cmpeq_epi32(v, _mm_setzero_si128());
+	return (_mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1))));
+}
+
+//nuls de deux plateaux : cases occupees egales au masque du plateau
+static int	ties_sse2(const t_split_masks *m, const t_board_soa *soa, int b)
+{
+	__m128i	diff;
+
+	diff = _mm_or_si128(
+			_mm_xor_si128(_mm_loadu_si128((const __m128i *)(soa->occ_lo + b)),
+				_mm_set1_epi64x((long long)m->full_lo)),
+			_mm_xor_si128(_mm_loadu_si128((const __m128i *)(soa->occ_hi + b)),
+				_mm_set1_epi64x((long long)m->full_hi)));
+	return (_mm_movemask_pd(_mm_castsi128_pd(zero_lanes_sse2(diff))));
+}
+
+//quatre plateaux par tour dans deux registres, qui partagent le chargement de chaque masque
+static int	batch_sse2(const t_split_masks *m, const t_board_soa *soa,
+	uint64_t *wins, uint64_t *ties)
+{
+	__m128i	lo[2];
+	__m128i	hi[2];
+	__m128i	won[2];
+	__m128i	mlo;
+	__m128i	mhi;
+	int		b;
+
+	b = 0;
+	for (; b + 4 <= soa->nb; b += 4)
+	{
+		for (int r = 0; r < 2; r++)
+		{
+			lo[r] = _mm_loadu_si128((const __m128i *)(soa->lo + b + 2 * r));
+			hi[r] = _mm_loadu_si128((const __m128i *)(soa->hi + b + 2 * r));
+			won[r] = _mm_setzero_si128();
+		}
+		for (int i = 0; i < m->nb_lines; i++)
+		{
+			mlo = _mm_set1_epi64x((long long)m->lo[i]);
+			mhi = _mm_set1_epi64x((long long)m->hi[i]);
+			for (int r = 0; r < 2; r++)
+				won[r] = _mm_or_si128(won[r], zero_lanes_sse2(_mm_or_si128(
+								_mm_andnot_si128(lo[r], mlo), _mm_andnot_si128(hi[r], mhi))));
+			if ((i & 7) == 7 && _mm_movemask_pd(_mm_castsi128_pd(_mm_and_si128(won[0],
+							won[1]))) == 3)
+				break ; //les quatre plateaux ont deja gagne (teste toutes les 8 lignes)
+		}
+		wins[b >> 6] |= (uint64_t)(_mm_movemask_pd(_mm_castsi128_pd(won[0]))
+				| _mm_movemask_pd(_mm_castsi128_pd(won[1])) << 2) << (b & 63);
+		ties[b >> 6] |= (uint64_t)(ties_sse2(m, soa, b) | ties_sse2(m, soa, b + 2) << 2)
+			<< (b & 63);
+	}
+	return (b);
+}
+
+//quatre plateaux par registre, avec la comparaison 64 bits d'AVX2
+__attribute__((target("avx2")))
+static int	batch_avx2(const t_split_masks *m, const t_board_soa *soa,
+	uint64_t *wins, uint64_t *ties)
+{
+	__m256i	lo;
+	__m256i	hi;
+	__m256i	won;
+	__m256i	miss;
+	__m256i	zero;
+	int		b;
+
+	zero = _mm256_setzero_si256();
+	b = 0;
+	for (; b + 4 <= soa->nb; b += 4)
+	{
+		lo = _mm256_loadu_si256((const __m256i *)(soa->lo + b));
+		hi = _mm256_loadu_si256((const __m256i *)(soa->hi + b));
+		won = zero;
+		for (int i = 0; i < m->nb_lines; i++)
+		{
+			miss = _mm256_or_si256(
+					_mm256_andnot_si256(lo, _mm256_set1_epi64x((long long)m->lo[i])),
+					_mm256_andnot_si256(hi, _mm256_set1_epi64x((long long)m->hi[i])));
+			won = _mm256_or_si256(won, _mm256_cmpeq_epi64(miss, zero));
+			if ((i & 7) == 7 && _mm256_movemask_pd(_mm256_castsi256_pd(won)) == 15)
+				break ; //les quatre plateaux ont deja gagne
+		}
+		wins[b >> 6] |= (uint64_t)_mm256_movemask_pd(_mm256_castsi256_pd(won)) << (b & 63);
+		miss = _mm256_or_si256(
+				_mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(soa->occ_lo + b)),
+					_mm256_set1_epi64x((long long)m->full_lo)),
+				_mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(soa->occ_hi + b)),
+					_mm256_set1_epi64x((long long)m->full_hi)));
+		ties[b >> 6] |= (uint64_t)_mm256_movemask_pd(_mm256_castsi256_pd(
+					_mm256_cmpeq_epi64(miss, zero))) << (b & 63);
+	}
+	return (b);
+}
+#endif
+
+//meilleure version que le processeur sait executer
+int	win_batch_best(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	if (__builtin_cpu_supports("avx2"))
+		return (WINBATCH_AVX2);
+	if (__builtin_cpu_supports("sse2"))
+		return (WINBATCH_SSE2);
+#endif
+	return (WINBATCH_SCALAR);
+}
+
+//victoire et nul d'un lot de plateaux de meme taille, avec la version impl
+//bit b de wins : le joueur de soa->lo/hi a un alignement complet sur le plateau b (verifierGagnantDynamic)
+//bit b de ties : le plateau b est plein (verifierMatchNul) ; wins et ties ont (nb + 63) / 64 mots
+//une version que le processeur ne sait pas executer retombe sur la boucle simple
+void	win_batch_impl(int impl, const t_winmasks *w, const t_board_soa *soa,
+	uint64_t *wins, uint64_t *ties)
+{
+	t_split_masks	m;
+	int				done;
+
+	split_masks(w, &m);
+	memset(wins, 0, sizeof(uint64_t) * (size_t)((soa->nb + 63) / 64));
+	memset(ties, 0, sizeof(uint64_t) * (size_t)((soa->nb + 63) / 64));
+	done = 0;
+#if defined(__x86_64__) || defined(__i386__)
+	if (impl == WINBATCH_AVX2 && __builtin_cpu_supports("avx2"))
+		done = batch_avx2(&m, soa, wins, ties);
+	else if (impl >= WINBATCH_SSE2 && __builtin_cpu_supports("sse2"))
+		done = batch_sse2(&m, soa, wins, ties);
+#else
+	(void)impl;
+#endif
+	batch_scalar(&m, soa, done, wins, ties); //plateaux restants (moins d'un registre)
+}
+
+//meme chose avec la meilleure version disponible
+void	win_batch(const t_winmasks *w, const t_board_soa *soa, uint64_t *wins, uint64_t *ties)
+{
+	win_batch_impl(win_batch_best(), w, soa, wins, ties);
+}